@@ -0,0 +1,147 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Общие функции генераторов нагрузки: время, выборки задержек с перцентилями и вывод JSON
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_NSEC_PER_SEC 1000000000ULL
+
+// Текущее время CLOCK_MONOTONIC в наносекундах (те же часы, что ktime_get() в модулях)
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * BENCH_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+// Выборка значений (нс); при заполнении сохраняется каждое второе значение,
+// чтобы длинный прогон не требовал неограниченной памяти. Минимум и максимум
+// учитываются по всем поступившим значениям, перцентили и среднее - по сохраненным
+struct bench_samples {
+    uint64_t *v;       // Значения
+    size_t n;          // Количество значений
+    size_t cap;        // Емкость
+    unsigned int skip; // Сохраняется одно из 2^skip значений
+    uint64_t seen;     // Количество поступивших значений
+    uint64_t min;      // Точный минимум
+    uint64_t max;      // Точный максимум
+};
+
+#define BENCH_MAX_SAMPLES (8u << 20) // Наибольшее количество сохраняемых значений
+
+static inline void bench_samples_add(struct bench_samples *s, uint64_t val) {
+    if (!s->seen || val < s->min) {
+        s->min = val;
+    }
+    if (val > s->max) {
+        s->max = val;
+    }
+    if (s->seen++ & ((1ULL << s->skip) - 1)) {
+        return;
+    }
+    if (s->n == s->cap) {
+        if (s->cap >= BENCH_MAX_SAMPLES) {
+            size_t i;
+
+            // Прореживание уже сохраненных значений
+            for (i = 0; i < s->n / 2; i++) {
+                s->v[i] = s->v[2 * i];
+            }
+            s->n /= 2;
+            s->skip++;
+        } else {
+            s->cap = s->cap ? 2 * s->cap : 4096;
+            s->v = realloc(s->v, s->cap * sizeof(*s->v));
+            if (!s->v) {
+                perror("realloc");
+                exit(1);
+            }
+        }
+    }
+    s->v[s->n++] = val;
+}
+
+// Добавление выборки src (например, потока) к dst: count, min и max остаются точными,
+// сохраненные значения src добавляются без учета их прореживания
+static inline void bench_samples_merge(struct bench_samples *dst, const struct bench_samples *src) {
+    uint64_t seen = dst->seen + src->seen;
+    uint64_t min = dst->seen && dst->min < src->min ? dst->min : src->min;
+    uint64_t max = dst->max > src->max ? dst->max : src->max;
+    size_t i;
+
+    if (!src->seen) {
+        return;
+    }
+    for (i = 0; i < src->n; i++) {
+        bench_samples_add(dst, src->v[i]);
+    }
+    dst->seen = seen;
+    dst->min = min;
+    dst->max = max;
+}
+
+static int bench_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// Вывод выборки как объекта JSON: count, min, avg, p50, p90, p99, p999, p9999, max
+static inline void bench_samples_json(FILE *f, const char *name, struct bench_samples *s) {
+    static const struct { const char *name; double q; } pct[] = {
+        { "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p999", 0.999 }, { "p9999", 0.9999 },
+    };
+    long double sum = 0;
+    size_t i;
+
+    fprintf(f, "\"%s\": {\"count\": %llu", name, (unsigned long long)s->seen);
+    if (s->n) {
+        qsort(s->v, s->n, sizeof(*s->v), bench_cmp_u64);
+        for (i = 0; i < s->n; i++) {
+            sum += s->v[i];
+        }
+        fprintf(f, ", \"min\": %llu, \"avg\": %.0Lf", (unsigned long long)s->min, sum / s->n);
+        for (i = 0; i < sizeof(pct) / sizeof(pct[0]); i++) {
+            fprintf(f, ", \"%s\": %llu", pct[i].name, (unsigned long long)s->v[(size_t)(pct[i].q * (s->n - 1))]);
+        }
+        fprintf(f, ", \"max\": %llu", (unsigned long long)s->max);
+    }
+    fprintf(f, "}");
+}
+
+// Чтение числа из файла sysfs/debugfs; при ошибке - 0
+static inline unsigned long long bench_read_ull(const char *path) {
+    unsigned long long val = 0;
+    FILE *f = fopen(path, "r");
+
+    if (f) {
+        if (fscanf(f, "%llu", &val) != 1) {
+            val = 0;
+        }
+        fclose(f);
+    }
+    return val;
+}
+
+// Запись строки в файл sysfs/debugfs
+static inline int bench_write_str(const char *path, const char *val) {
+    FILE *f = fopen(path, "w");
+    int ret;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    ret = fputs(val, f) < 0 ? -1 : 0;
+    if (fclose(f)) {
+        ret = -1;
+    }
+    return ret;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+# Сравнение двух отчетов results.json (например, стандартное ядро и PREEMPT_RT или два коммита).
+# Печатает таблицу показателей прогонов и завершается с кодом 1, если пропускная способность
+# упала или задержка выросла больше порога, либо прогон не удался только во втором отчете
+#
+# Использование: compare.py [-t порог_%] старый.json новый.json
+
+import argparse
+import json
+import sys
+
+# Перцентили задержки, по которым проверяется ухудшение; p99.9, p99.99 и max выводятся,
+# но на коротком прогоне слишком шумны для автоматической проверки
+GATED_PCT = ("avg", "p50", "p90", "p99")
+SHOWN_PCT = GATED_PCT + ("p999", "p9999", "max")
+
+
+def metrics(run):
+    """Показатели прогона: (имя, значение, больше - лучше, проверяется)"""
+    for key, val in run.items():
+        if isinstance(val, dict):
+            if key.endswith("_ns"):
+                for pct in SHOWN_PCT:
+                    if pct in val:
+                        yield f"{key}.{pct}", val[pct], False, pct in GATED_PCT
+            else:
+                for name, v, higher, gated in metrics(val):
+                    yield f"{key}.{name}", v, higher, gated
+        elif isinstance(val, (int, float)) and not isinstance(val, bool):
+            if key.endswith("_per_s") or key == "pps":
+                yield key, val, True, True
+            elif key in ("dropped", "missed"):
+                yield key, val, False, False
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Compare two benchmark results.json files")
+    ap.add_argument("-t", "--threshold", type=float, default=10.0,
+                    help="regression threshold in percent (default 10)")
+    ap.add_argument("old")
+    ap.add_argument("new")
+    args = ap.parse_args()
+
+    with open(args.old) as f:
+        old = json.load(f)
+    with open(args.new) as f:
+        new = json.load(f)
+
+    for r, name in ((old, args.old), (new, args.new)):
+        print(f"{name}: {r['kernel']} preempt_rt={r['preempt_rt']} cpus={r['cpus']} stress={r['stress']}")
+    print()
+    print(f"{'run':<28} {'metric':<32} {'old':>14} {'new':>14} {'change':>9}")
+
+    regressions = []
+    for run in sorted(set(old["runs"]) | set(new["runs"])):
+        if run not in new["runs"] or run not in old["runs"]:
+            print(f"{run:<28} {'(missing in ' + ('new' if run in old['runs'] else 'old') + ')':<32}")
+            continue
+        old_m = {name: v for name, v, _, _ in metrics(old["runs"][run])}
+        for name, v, higher, gated in metrics(new["runs"][run]):
+            if name not in old_m:
+                continue
+            o = old_m[name]
+            change = (v - o) * 100.0 / o if o else 0.0
+            worse = -change if higher else change
+            mark = ""
+            if gated and worse > args.threshold:
+                mark = " !"
+                regressions.append(f"{run} {name}")
+            print(f"{run:<28} {name:<32} {o:>14} {v:>14} {change:>+8.1f}%{mark}")
+
+    for run in new.get("failed", []):
+        if run not in old.get("failed", []):
+            regressions.append(f"{run} failed")
+
+    if regressions:
+        print(f"\nregressions beyond {args.threshold:g}%:")
+        for r in regressions:
+            print(f"  {r}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
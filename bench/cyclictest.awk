@@ -0,0 +1,63 @@
+# Перевод вывода cyclictest -h -q (гистограмма в мкс по процессорам) в отчет JSON
+# в формате bench_samples_json() (наносекунды). Перцентиль, попавший в переполнение
+# гистограммы, заменяется наибольшей задержкой
+
+/^# Avg Latencies:/ {
+    for (i = 4; i <= NF; i++) {
+        avg += $i
+        cpus++
+    }
+    next
+}
+/^# Min Latencies:/ {
+    for (i = 4; i <= NF; i++) {
+        if (min == "" || $i + 0 < min) {
+            min = $i + 0
+        }
+    }
+    next
+}
+/^# Max Latencies:/ {
+    for (i = 4; i <= NF; i++) {
+        if ($i + 0 > max) {
+            max = $i + 0
+        }
+    }
+    next
+}
+/^# Histogram Overflows:/ {
+    for (i = 4; i <= NF; i++) {
+        total += $i
+    }
+    next
+}
+/^[0-9]/ {
+    for (i = 2; i <= NF; i++) {
+        hist[$1 + 0] += $i
+        total += $i
+    }
+    if ($1 + 0 > top) {
+        top = $1 + 0
+    }
+}
+
+function pct(q,    need, sum, b) {
+    need = q * total
+    for (b = 0; b <= top; b++) {
+        sum += hist[b]
+        if (sum >= need) {
+            return b * 1000
+        }
+    }
+    return max * 1000
+}
+
+END {
+    printf "{\"module\": \"cyclictest\", \"latency_ns\": {\"count\": %d", total
+    if (total) {
+        printf ", \"min\": %d, \"avg\": %d", min * 1000, cpus ? avg * 1000 / cpus : 0
+        printf ", \"p50\": %d, \"p90\": %d, \"p99\": %d", pct(0.5), pct(0.9), pct(0.99)
+        printf ", \"p999\": %d, \"p9999\": %d, \"max\": %d", pct(0.999), pct(0.9999), max * 1000
+    }
+    printf "}}\n"
+}
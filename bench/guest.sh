@@ -0,0 +1,247 @@
+#!/bin/sh
+# Прогон измерений внутри гостевой системы (запускается из run.sh через vng --exec, от root).
+# Загружает модули по очереди, запускает генераторы нагрузки и записывает отчеты JSON в каталог
+# результатов: по файлу на прогон и сводный results.json с описанием ядра.
+#
+# Использование: guest.sh <каталог_результатов> (модули - в его подкаталоге modules)
+# Переменные окружения:
+#   BENCH_DURATION - длительность одного прогона в секундах (по умолчанию 10);
+#   BENCH_STRESS   - фоновая нагрузка: none, cpu (занятые процессоры), irq (шторм таймерных
+#                    прерываний) или cpu,irq (по умолчанию none)
+
+set -u
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+OUT=${1:-$BENCH/results}
+D=${BENCH_DURATION:-10}
+STRESS=${BENCH_STRESS:-none}
+NCPU=$(nproc)
+FAILED=""
+STRESS_PIDS=""
+
+mkdir -p "$OUT"
+rm -f "$OUT"/*.json
+
+log() {
+    echo "bench: $*" >&2
+}
+
+# Прогон генератора: run <имя> <команда...>; отчет - $OUT/<имя>.json
+run() {
+    name=$1
+    shift
+    log "$name"
+    if ! "$@" > "$OUT/$name.json"; then
+        FAILED="$FAILED $name"
+        [ -s "$OUT/$name.json" ] || rm -f "$OUT/$name.json" # Без отчета сводный JSON остается корректным
+    fi
+}
+
+# Загрузка модуля, собранного run.sh: load <модуль> [параметры...]
+load() {
+    mod=$1
+    shift
+    if ! insmod "$OUT/modules/$mod/$mod.ko" "$@"; then
+        log "insmod $mod failed"
+        FAILED="$FAILED $mod"
+        return 1
+    fi
+}
+
+# Узел устройства для register_chrdev() без класса: номер берется из /proc/devices
+mknode() {
+    major=$(awk -v n="$1" '$2 == n { print $1 }' /proc/devices)
+    rm -f "/dev/$1"
+    mknod "/dev/$1" c "$major" 0
+}
+
+# Фоновая нагрузка на время всех прогонов
+stress_start() {
+    case ",$STRESS," in
+        *,cpu,*)
+            if command -v stress-ng > /dev/null; then
+                stress-ng --cpu "$NCPU" --quiet &
+                STRESS_PIDS="$STRESS_PIDS $!"
+            else
+                for i in $(seq "$NCPU"); do
+                    sh -c 'while :; do :; done' &
+                    STRESS_PIDS="$STRESS_PIDS $!"
+                done
+            fi
+            ;;
+    esac
+    case ",$STRESS," in
+        *,irq,*)
+            if ! command -v stress-ng > /dev/null; then
+                log "stress-ng is required for BENCH_STRESS=irq"
+                exit 1
+            fi
+            stress-ng --timer "$NCPU" --timer-freq 100000 --quiet &
+            STRESS_PIDS="$STRESS_PIDS $!"
+            ;;
+    esac
+}
+
+stress_stop() {
+    for pid in $STRESS_PIDS; do
+        kill "$pid" 2> /dev/null
+    done
+    wait 2> /dev/null
+}
+
+trap stress_stop EXIT
+mount -t debugfs none /sys/kernel/debug 2> /dev/null
+stress_start
+
+# ПЗ_1: пропускная способность и задержка блока через буфер устройства; масштабирование -
+# 1, 2, 4, ... пар писатель-читатель на разных экземплярах, пока на пару хватает двух процессоров
+OC_MAX=$(( NCPU / 2 ))
+[ "$OC_MAX" -ge 1 ] || OC_MAX=1
+if load oldchar buffer_size=1048576 minors="$OC_MAX"; then
+    udevadm settle 2> /dev/null
+    run oldchar_4k "$BENCH/oldchar_load" -d "$D" -b 4096
+    run oldchar_64k "$BENCH/oldchar_load" -d "$D" -b 65536
+    # Векторный ввод-вывод и splice() против read()/write() при том же размере блока
+    run oldchar_64k_vec "$BENCH/oldchar_load" -d "$D" -b 65536 -m vec
+    run oldchar_64k_splice "$BENCH/oldchar_load" -d "$D" -b 65536 -m splice
+    n=2
+    while [ "$n" -le "$OC_MAX" ]; do
+        run oldchar_64k_x$n "$BENCH/oldchar_load" -d "$D" -b 65536 -n "$n"
+        n=$(( n * 2 ))
+    done
+    rmmod oldchar
+fi
+
+# ПЗ_2: задание 0 с периодом 100 мкс и 1000 заданий с периодами 1-4 мс в кольцах
+if load sleep_module output=ring period_ns=100000 message=bench; then
+    mknode sleep_module
+    for i in $(seq 1 1000); do
+        echo "$i $(( (i % 4 + 1) * 1000000 )) job $i" > /sys/kernel/sleep_module/job_add
+    done
+    run sleep_module "$BENCH/sleep_load" -d "$D"
+    # Стоимость изменения message и period_ns каждые 100 мкс при той же нагрузке
+    run sleep_module_update "$BENCH/sleep_load" -d "$D" -u 100
+    rmmod sleep_module
+fi
+
+# ПЗ_2: масштабирование по числу заданий 10 - 100000 с периодами 10-40 мс; задания
+# добавляются к уже существующим, время процессора рабочих потоков - на одно выполнение
+if load sleep_module output=ring ring_entries=16384 message=bench; then
+    mknode sleep_module
+    for n in 10 100 1000 10000 100000; do
+        run sleep_module_jobs_$n "$BENCH/sleep_load" -d "$D" -j "$n"
+    done
+    rmmod sleep_module
+fi
+
+# ПЗ_3: задержка пробуждения потоков реального времени (cyclictest, гистограмма в мкс)
+if command -v cyclictest > /dev/null; then
+    log cyclictest
+    if cyclictest -m -S -p 90 -i 1000 -D "${D}s" -h 10000 -q > "$OUT/cyclictest.txt"; then
+        awk -f "$BENCH/cyclictest.awk" "$OUT/cyclictest.txt" > "$OUT/cyclictest.json"
+    else
+        FAILED="$FAILED cyclictest"
+    fi
+else
+    log "cyclictest not found, skipped"
+fi
+
+# ПЗ_4: задержка уведомления, проверка управления таймером и снимок 10000 счетчиков
+if load symbolic_driver counters=10000; then
+    run symbolic_driver "$BENCH/symbolic_load" -d "$D" -p 1000000 -t "$NCPU"
+    rmmod symbolic_driver
+fi
+
+# ЛР_2: время реакции на всех процессорах с периодом воздействия 1 мс
+if load reaction_time_analyzer; then
+    mknode reaction_time_analyzer
+    run reaction_time_analyzer "$BENCH/rta_load" -d "$D" -p 1000000
+    rmmod reaction_time_analyzer
+fi
+
+# ЛР_1: pps pktgen на cpswlo0 при пачках 1 и 32 и захвате выключен / с несовпадающим фильтром /
+# включен. Модуль загружается заново на каждый прогон, чтобы счетчики канала начинались с нуля
+CAP=/sys/kernel/debug/cpsw_capture
+LO=/sys/kernel/debug/cpsw_lo
+PG=/proc/net/pktgen
+if modprobe pktgen; then
+    for burst in 1 32; do
+        for mode in off nomatch on; do
+            name=cpsw_lo_burst${burst}_$mode
+            load cpsw_lo || break 2
+            ip link set cpswlo0 up
+            echo "add_device cpswlo0" > $PG/kpktgend_0
+            P=$PG/cpswlo0
+            echo "count 0" > $P
+            echo "pkt_size 64" > $P
+            echo "burst $burst" > $P
+            echo "dst 10.0.0.2" > $P
+            echo "udp_dst_min 9000" > $P
+            echo "udp_dst_max 9000" > $P
+            echo "dst_mac $(cat /sys/class/net/cpswlo0/address)" > $P
+            case $mode in
+                nomatch) echo "port=9" > $CAP/filter; echo 1 > $CAP/enable ;;
+                on) echo 1 > $CAP/enable ;;
+            esac
+
+            log "$name"
+            "$BENCH/cpsw_cap_read" -d "$D" > "$OUT/$name.cap" &
+            reader=$!
+            echo start > $PG/pgctrl & # Запись блокируется до остановки pktgen
+            pktgen=$!
+            sleep "$D"
+            echo stop > $PG/pgctrl
+            wait $pktgen $reader
+            pps=$(sed -n 's/^ *\([0-9][0-9]*\)pps.*/\1/p' $P)
+            # Отчет читателя колец дополняется pps и счетчиками программного канала DMA
+            {
+                printf '{"module": "cpsw_lo", "burst": %s, "capture": "%s", "pps": %s, ' "$burst" "$mode" "${pps:-0}"
+                printf '"kicks": %s, "completed": %s, "lat_sum_ns": %s, "lat_max_ns": %s, "capture_rates": ' \
+                    "$(cat $LO/kicks)" "$(cat $LO/completed)" "$(cat $LO/lat_sum_ns)" "$(cat $LO/lat_max_ns)"
+                cat "$OUT/$name.cap"
+                echo "}"
+            } > "$OUT/$name.json"
+            rm -f "$OUT/$name.cap"
+            [ -n "$pps" ] || FAILED="$FAILED $name"
+
+            ip link set cpswlo0 down
+            rmmod cpsw_lo
+        done
+    done
+    rmmod pktgen
+else
+    log "pktgen not available, cpsw_lo skipped"
+fi
+
+stress_stop
+trap - EXIT
+
+# Сводный отчет: описание ядра и прогоны
+if [ -e /sys/kernel/realtime ] && [ "$(cat /sys/kernel/realtime)" = 1 ]; then
+    rt=true
+else
+    rt=false
+fi
+{
+    printf '{"kernel": "%s", "version": "%s", "preempt_rt": %s, "cpus": %s, "duration_s": %s, "stress": "%s", ' \
+        "$(uname -r)" "$(uname -v)" "$rt" "$NCPU" "$D" "$STRESS"
+    printf '"failed": ['
+    sep=""
+    for f in $FAILED; do
+        printf '%s"%s"' "$sep" "$f"
+        sep=", "
+    done
+    printf '], "runs": {'
+    sep=""
+    for f in "$OUT"/*.json; do
+        [ -e "$f" ] && [ "$f" != "$OUT/results.json" ] || continue
+        printf '%s\n"%s": ' "$sep" "$(basename "$f" .json)"
+        cat "$f"
+        sep=","
+    done
+    echo "}}"
+} > "$OUT/results.json.tmp"
+mv "$OUT/results.json.tmp" "$OUT/results.json"
+
+log "results in $OUT/results.json${FAILED:+, failed:$FAILED}"
+[ -z "$FAILED" ]
@@ -0,0 +1,273 @@
+// Генератор нагрузки oldchar: в каждом из N экземпляров устройства поток-писатель пишет блоки
+// с меткой времени, а поток-читатель читает их из того же экземпляра. Выводит суммарную
+// пропускную способность и задержку блока от записи до чтения; прогоны с разным N
+// показывают масштабирование по экземплярам.
+// Способ передачи (-m):
+//  - rw: read()/write();
+//  - vec: readv()/writev(), блок передается массивом из VEC_PARTS частей;
+//  - splice: писатель передает блок через канал (vmsplice() и splice() в устройство), читатель
+//    переносит данные из устройства через канал в /dev/null, не копируя их в свой буфер.
+//    Содержимое блоков при этом не читается, поэтому задержка и порядок не проверяются
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+static const char *dev_prefix = "/dev/oldchardev"; // Устройства: <префикс><номер экземпляра>
+static size_t block = 4096; // Размер блока
+static volatile int stop;   // Конец прогона
+
+#define VEC_PARTS 4 // Количество iovec на вызов в режиме vec
+
+enum { MODE_RW, MODE_VEC, MODE_SPLICE };
+static const char *mode_names[] = { "rw", "vec", "splice" };
+static int mode = MODE_RW; // Способ передачи
+
+// Заголовок блока
+struct block_hdr {
+    uint64_t seq;     // Номер блока
+    uint64_t time_ns; // Время записи
+};
+
+// Пара писатель - читатель на одном экземпляре устройства
+struct pair {
+    pthread_t writer, reader;
+    int wfd, rfd;
+    struct bench_samples lat;  // Задержка блока
+    unsigned long long bytes;  // Прочитанные байты
+    int failed;                // Ошибка чтения или нарушен порядок блоков
+};
+
+// Один вызов чтения или записи (out) не более len байт: rw или vec
+static ssize_t xfer(int fd, char *buf, size_t len, int out) {
+    struct iovec iov[VEC_PARTS];
+    size_t off, part = (len + VEC_PARTS - 1) / VEC_PARTS;
+    int n = 0;
+
+    if (mode == MODE_RW) {
+        return out ? write(fd, buf, len) : read(fd, buf, len);
+    }
+    for (off = 0; off < len; off += part) {
+        iov[n].iov_base = buf + off;
+        iov[n].iov_len = len - off < part ? len - off : part;
+        n++;
+    }
+    return out ? writev(fd, iov, n) : readv(fd, iov, n);
+}
+
+// Запись len байт в устройство через канал: страницы буфера передаются в канал без
+// копирования, а из канала копируются сразу в буфер устройства
+static ssize_t splice_out(int fd, int pipefd[2], char *buf, size_t len) {
+    struct iovec iov = { .iov_base = buf, .iov_len = len };
+    ssize_t n = vmsplice(pipefd[1], &iov, 1, 0), moved, ret;
+
+    for (moved = 0; n > 0 && moved < n; moved += ret) {
+        ret = splice(pipefd[0], NULL, fd, NULL, n - moved, SPLICE_F_MOVE);
+        if (ret <= 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+static void *writer_fn(void *arg) {
+    struct pair *p = arg;
+    char *buf = calloc(1, block);
+    struct block_hdr *h = (struct block_hdr *)buf;
+    int pipefd[2];
+    size_t done;
+    ssize_t ret;
+
+    if (mode == MODE_SPLICE && pipe(pipefd)) {
+        perror("pipe");
+        goto out;
+    }
+    while (!stop) {
+        h->time_ns = bench_now_ns();
+        for (done = 0; done < block; done += ret) {
+            if (mode == MODE_SPLICE) {
+                ret = splice_out(p->wfd, pipefd, buf + done, block - done);
+            } else {
+                ret = xfer(p->wfd, buf + done, block - done, 1);
+            }
+            if (ret < 0) {
+                perror("write");
+                goto out;
+            }
+        }
+        h->seq++;
+    }
+    if (mode == MODE_SPLICE) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+    }
+out:
+    close(p->wfd); // Читатель получает конец файла после опустошения буфера
+    free(buf);
+    return NULL;
+}
+
+// Читатель splice: устройство -> канал -> /dev/null
+static void splice_reader(struct pair *p) {
+    int pipefd[2], nullfd = open("/dev/null", O_WRONLY);
+    ssize_t ret, moved, n;
+
+    if (nullfd < 0 || pipe(pipefd)) {
+        perror("splice setup");
+        p->failed = 1;
+        return;
+    }
+    for (;;) {
+        ret = splice(p->rfd, NULL, pipefd[1], NULL, block, SPLICE_F_MOVE);
+        if (ret <= 0) {
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret < 0) {
+                perror("splice");
+                p->failed = 1;
+            }
+            break;
+        }
+        for (moved = 0; moved < ret; moved += n) {
+            n = splice(pipefd[0], NULL, nullfd, NULL, ret - moved, SPLICE_F_MOVE);
+            if (n <= 0) {
+                perror("splice");
+                p->failed = 1;
+                goto out;
+            }
+        }
+        p->bytes += ret;
+    }
+out:
+    close(pipefd[0]);
+    close(pipefd[1]);
+    close(nullfd);
+}
+
+static void *reader_fn(void *arg) {
+    struct pair *p = arg;
+    char *buf = malloc(block);
+    uint64_t expect = 0;
+    size_t done;
+    ssize_t ret;
+
+    if (mode == MODE_SPLICE) {
+        splice_reader(p);
+        goto out;
+    }
+    for (;;) {
+        for (done = 0; done < block; done += ret) {
+            ret = xfer(p->rfd, buf + done, block - done, 0);
+            if (ret <= 0) {
+                if (ret < 0 && errno == EINTR) {
+                    ret = 0;
+                    continue;
+                }
+                if (ret < 0) {
+                    perror("read");
+                    p->failed = 1;
+                }
+                goto out;
+            }
+        }
+        if (((struct block_hdr *)buf)->seq != expect++) {
+            fprintf(stderr, "block out of order\n");
+            p->failed = 1;
+            stop = 1;
+            goto out;
+        }
+        bench_samples_add(&p->lat, bench_now_ns() - ((struct block_hdr *)buf)->time_ns);
+        p->bytes += block;
+    }
+out:
+    free(buf);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    struct bench_samples lat = {0};
+    unsigned int duration = 10, instances = 1, i;
+    unsigned long long bytes = 0;
+    uint64_t start, end;
+    struct pair *pairs;
+    char path[64];
+    int opt, failed = 0;
+
+    while ((opt = getopt(argc, argv, "d:b:n:m:f:")) != -1) {
+        switch (opt) {
+            case 'd': duration = atoi(optarg); break;
+            case 'b': block = strtoul(optarg, NULL, 0); break;
+            case 'n': instances = atoi(optarg); break;
+            case 'm':
+                mode = MODE_SPLICE;
+                while (mode > MODE_RW && strcmp(optarg, mode_names[mode])) {
+                    mode--;
+                }
+                if (strcmp(optarg, mode_names[mode])) {
+                    fprintf(stderr, "unknown mode %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'f': dev_prefix = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-b block_bytes] [-n instances] [-m rw|vec|splice] [-f device_prefix]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (block < sizeof(struct block_hdr)) {
+        block = sizeof(struct block_hdr);
+    }
+    if (!instances) {
+        instances = 1;
+    }
+    pairs = calloc(instances, sizeof(*pairs));
+    if (!pairs) {
+        perror("calloc");
+        return 1;
+    }
+    for (i = 0; i < instances; i++) {
+        snprintf(path, sizeof(path), "%s%u", dev_prefix, i);
+        pairs[i].rfd = open(path, O_RDONLY);
+        pairs[i].wfd = open(path, O_WRONLY);
+        if (pairs[i].wfd < 0 || pairs[i].rfd < 0) {
+            perror(path);
+            return 1;
+        }
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < instances; i++) {
+        pthread_create(&pairs[i].reader, NULL, reader_fn, &pairs[i]);
+        pthread_create(&pairs[i].writer, NULL, writer_fn, &pairs[i]);
+    }
+    while (!stop && bench_now_ns() - start < duration * BENCH_NSEC_PER_SEC) {
+        usleep(10000);
+    }
+    stop = 1; // Писатели закрывают устройства, читатели дочитывают буферы до конца файла
+    for (i = 0; i < instances; i++) {
+        pthread_join(pairs[i].writer, NULL);
+        pthread_join(pairs[i].reader, NULL);
+    }
+    end = bench_now_ns();
+    for (i = 0; i < instances; i++) {
+        bytes += pairs[i].bytes;
+        failed |= pairs[i].failed;
+        bench_samples_merge(&lat, &pairs[i].lat);
+        close(pairs[i].rfd);
+    }
+
+    printf("{\"module\": \"oldchar\", \"mode\": \"%s\", \"instances\": %u, \"block\": %zu, \"duration_s\": %.3f, "
+           "\"bytes_per_s\": %.0f, \"instance_bytes_per_s\": %.0f, \"blocks_per_s\": %.1f, ",
+           mode_names[mode], instances, block, (end - start) / 1e9, bytes * 1e9 / (end - start),
+           bytes * 1e9 / (end - start) / instances, (double)(bytes / block) * 1e9 / (end - start));
+    bench_samples_json(stdout, "block_latency_ns", &lat);
+    printf("}\n");
+    return failed;
+}
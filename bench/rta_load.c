@@ -0,0 +1,138 @@
+// Генератор нагрузки reaction_time_analyzer: на каждом процессоре поток регистрируется,
+// ждет воздействие в блокирующем read() и сразу подтверждает реакцию write().
+// Распределения считает модуль, генератор выводит их в JSON
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "reaction_time_analyzer.h"
+
+static const char *dev_path = "/dev/reaction_time_analyzer"; // Устройство
+static volatile int stop; // Конец прогона
+
+struct worker {
+    pthread_t thread;
+    unsigned int cpu;
+    int fd;
+    int failed;                   // Регистрация или ожидание завершились ошибкой
+    unsigned long long reactions; // Принятые модулем подтверждения
+};
+
+static void *worker_fn(void *arg) {
+    struct worker *w = arg;
+    struct rta_notify n = { .cpu = w->cpu, .mode = RTA_NOTIFY_WAIT };
+    __u64 seq;
+
+    if (ioctl(w->fd, IOCTL_REGISTER_TARGET, &w->cpu) || ioctl(w->fd, IOCTL_SET_NOTIFY, &n)) {
+        perror("register");
+        w->failed = 1;
+        return NULL;
+    }
+    while (!stop) {
+        if (read(w->fd, &seq, sizeof(seq)) != sizeof(seq)) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("read");
+            w->failed = 1;
+            break;
+        }
+        if (write(w->fd, &seq, 1) < 0) {
+            if (errno == EAGAIN) {
+                continue; // Воздействие не принято модулем и не считается
+            }
+            perror("write");
+            w->failed = 1;
+            break;
+        }
+        w->reactions++;
+    }
+    ioctl(w->fd, IOCTL_UNREGISTER_TARGET, &w->cpu);
+    return NULL;
+}
+
+// Вывод struct stats модуля в формате bench_samples_json()
+static void stats_json(const char *name, const struct stats *s) {
+    static const char *pct[RTA_PERCENTILES] = { "p50", "p90", "p99", "p999", "p9999" };
+    unsigned int i;
+
+    printf("\"%s\": {\"count\": %llu", name, (unsigned long long)s->count);
+    if (s->count) {
+        printf(", \"min\": %llu, \"avg\": %llu", (unsigned long long)s->min_time,
+               (unsigned long long)s->average_time);
+        for (i = 0; i < RTA_PERCENTILES; i++) {
+            printf(", \"%s\": %llu", pct[i], (unsigned long long)s->percentiles[i]);
+        }
+        printf(", \"max\": %llu", (unsigned long long)s->max_time);
+    }
+    printf("}");
+}
+
+int main(int argc, char **argv) {
+    unsigned int duration = 10, nr_cpus = sysconf(_SC_NPROCESSORS_ONLN), i;
+    __u64 period_ns = 1000000;
+    struct stats reaction = { .size = sizeof(reaction) }, timer = { .size = sizeof(timer) };
+    unsigned long long total = 0;
+    struct worker *workers;
+    int opt, fd, failed = 0;
+
+    while ((opt = getopt(argc, argv, "d:p:c:f:")) != -1) {
+        switch (opt) {
+            case 'd': duration = atoi(optarg); break;
+            case 'p': period_ns = strtoull(optarg, NULL, 0); break;
+            case 'c': nr_cpus = atoi(optarg); break;
+            case 'f': dev_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-p period_ns] [-c cpus] [-f device]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    fd = open(dev_path, O_RDWR);
+    if (fd < 0 || ioctl(fd, IOCTL_SET_PERIOD_NS, &period_ns) || ioctl(fd, IOCTL_RESET_STATS)) {
+        perror(dev_path);
+        return 1;
+    }
+    workers = calloc(nr_cpus, sizeof(*workers));
+    if (!workers) {
+        perror("calloc");
+        return 1;
+    }
+    for (i = 0; i < nr_cpus; i++) {
+        workers[i].cpu = i;
+        workers[i].fd = open(dev_path, O_RDWR);
+        if (workers[i].fd < 0) {
+            perror(dev_path);
+            return 1;
+        }
+    }
+    for (i = 0; i < nr_cpus; i++) {
+        pthread_create(&workers[i].thread, NULL, worker_fn, &workers[i]);
+    }
+    sleep(duration);
+    stop = 1; // Поток выходит после следующего воздействия
+    for (i = 0; i < nr_cpus; i++) {
+        pthread_join(workers[i].thread, NULL);
+        total += workers[i].reactions;
+        failed |= workers[i].failed;
+        close(workers[i].fd);
+    }
+    if (ioctl(fd, IOCTL_GET_STATS, &reaction) || ioctl(fd, IOCTL_GET_TIMER_STATS, &timer)) {
+        perror("IOCTL_GET_STATS");
+        return 1;
+    }
+
+    printf("{\"module\": \"reaction_time_analyzer\", \"period_ns\": %llu, \"cpus\": %u, \"duration_s\": %u, "
+           "\"reactions_per_s\": %.1f, ", (unsigned long long)period_ns, nr_cpus, duration, (double)total / duration);
+    stats_json("reaction_ns", &reaction);
+    printf(", ");
+    stats_json("timer_lateness_ns", &timer);
+    printf("}\n");
+    return failed; // Отчет выводится, но прогон с ошибкой потока считается неудачным
+}
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Сборка модулей и генераторов нагрузки и прогон измерений в гостевой системе virtme-ng,
+# загруженной из собранного локального дерева ядра.
+#
+# Использование: run.sh <дерево_ядра> [каталог_результатов]
+# Переменные окружения BENCH_DURATION и BENCH_STRESS передаются в guest.sh;
+# VNG_OPTS - дополнительные параметры vng (например, "--cpus 4 --memory 2G")
+
+set -eu
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 <kernel_tree> [results_dir]" >&2
+    exit 2
+fi
+KDIR=$(cd "$1" && pwd)
+BENCH=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(dirname "$BENCH")
+OUT=$(mkdir -p "${2:-$BENCH/results}" && cd "${2:-$BENCH/results}" && pwd)
+
+# Модули собираются под гостевое ядро, а не под ядро хоста. kbuild не принимает пробелы в M=
+# и читает Kbuild или Makefile, поэтому исходники копируются в $OUT/modules/<модуль>, а Kbuild
+# составляется из строк obj-m, -objs и CFLAGS_ makefile модуля
+build() {
+    dst=$OUT/modules/$2
+    rm -rf "$dst"
+    mkdir -p "$dst"
+    cp "$ROOT/$1"/*.c "$ROOT/$1"/*.h "$dst"
+    tr -d '\r' < "$ROOT/$1/makefile" | grep -E '^(obj-m|[a-z_]+-objs|CFLAGS_)' > "$dst/Kbuild"
+    make -C "$KDIR" M="$dst" modules
+}
+build "ПЗ_1 Символьный драйвер в старом стиле" oldchar
+build "ПЗ_2 Вывод сообщения с заданной частотой" sleep_module
+build "ПЗ_4 Символьный драйвер с таймером и интерфейсом sysfs" symbolic_driver
+build "ЛР_2 Оценка задержки реакции на внешнее воздействие" reaction_time_analyzer
+build "ЛР_1 Патч для сетевого драйвера" cpsw_lo
+make -C "$BENCH"
+
+vng --run "$KDIR" --user root --rwdir "$OUT" ${VNG_OPTS:-} \
+    --exec "BENCH_DURATION=${BENCH_DURATION:-10} BENCH_STRESS=${BENCH_STRESS:-none} '$BENCH/guest.sh' '$OUT'"
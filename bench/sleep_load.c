@@ -0,0 +1,246 @@
+// Генератор нагрузки sleep_module (output=ring): забирает записи из колец всех рабочих потоков
+// через mmap() с ожиданием в poll(). Выводит количество сообщений в секунду, задержку доставки
+// записи читателю, статистику модуля из /sys/kernel/sleep_module и время процессора рабочих
+// потоков. С -j N перед прогоном добавляются задания 1..N (уже существующие пропускаются),
+// поэтому последовательные прогоны с растущим N измеряют масштабирование по числу заданий.
+// С -u мкс отдельный поток на время прогона меняет message и period_ns (чередуя два близких
+// периода) с заданным интервалом; выводится длительность каждой записи параметров и
+// стоимость изменения по update_ns модуля, чтобы сравнить дрожание с прогоном без -u
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "sleep_module.h"
+
+#define SYSFS "/sys/kernel/sleep_module/"
+#define PARAMS "/sys/module/sleep_module/parameters/"
+
+static volatile int stop; // Конец прогона
+
+// Поток изменения параметров
+struct updater {
+    pthread_t thread;
+    unsigned int interval_us;      // Пауза между изменениями
+    unsigned long long period_ns;  // Исходный период, восстанавливается в конце
+    unsigned long long updates;    // Выполненные изменения
+    struct bench_samples write_ns; // Длительность записи message и period_ns
+    int failed;
+};
+
+// Добавление заданий 1..n с периодами 10, 20, 30 и 40 мс; существующие номера пропускаются
+static int add_jobs(unsigned int n) {
+    int fd = open(SYSFS "job_add", O_WRONLY);
+    unsigned int i;
+    char buf[64];
+    int len;
+
+    if (fd < 0) {
+        perror(SYSFS "job_add");
+        return -1;
+    }
+    for (i = 1; i <= n; i++) {
+        len = snprintf(buf, sizeof(buf), "%u %u job %u", i, (i % 4 + 1) * 10000000, i);
+        if (pwrite(fd, buf, len, 0) < 0 && errno != EEXIST) {
+            perror("job_add");
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+static void *updater_fn(void *arg) {
+    struct updater *u = arg;
+    int mfd = open(PARAMS "message", O_WRONLY), pfd = open(PARAMS "period_ns", O_WRONLY);
+    char msg[32], period[32];
+    int mlen, plen;
+    uint64_t t;
+
+    if (mfd < 0 || pfd < 0) {
+        perror(PARAMS);
+        u->failed = 1;
+        return NULL;
+    }
+    while (!stop) {
+        mlen = snprintf(msg, sizeof(msg), "bench %llu", u->updates);
+        plen = snprintf(period, sizeof(period), "%llu", u->period_ns + u->updates % 2);
+        t = bench_now_ns();
+        if (pwrite(mfd, msg, mlen, 0) < 0 || pwrite(pfd, period, plen, 0) < 0) {
+            perror("update");
+            u->failed = 1;
+            break;
+        }
+        bench_samples_add(&u->write_ns, bench_now_ns() - t);
+        u->updates++;
+        if (u->interval_us) {
+            usleep(u->interval_us);
+        }
+    }
+    plen = snprintf(period, sizeof(period), "%llu", u->period_ns);
+    pwrite(pfd, period, plen, 0);
+    close(mfd);
+    close(pfd);
+    return NULL;
+}
+
+// Стоимость изменения параметров по модулю: "количество последняя наибольшая", нс
+static void read_update_ns(unsigned long long *count, unsigned long long *max_ns) {
+    FILE *f = fopen(SYSFS "update_ns", "r");
+    unsigned long long last;
+
+    *count = *max_ns = 0;
+    if (f) {
+        if (fscanf(f, "%llu %llu %llu", count, &last, max_ns) != 3) {
+            *count = *max_ns = 0;
+        }
+        fclose(f);
+    }
+}
+
+// Время процессора рабочих потоков sleep_worker/* (нс) по /proc/<pid>/stat
+static uint64_t workers_cpu_ns(void) {
+    unsigned long long utime, stime, ticks = 0;
+    DIR *dir = opendir("/proc");
+    struct dirent *de;
+    char path[300], buf[512], *p;
+    FILE *f;
+
+    if (!dir) {
+        return 0;
+    }
+    while ((de = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)de->d_name[0])) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/proc/%s/stat", de->d_name);
+        f = fopen(path, "r");
+        if (!f) {
+            continue;
+        }
+        // Поля после имени: состояние, 5 идентификаторов, флаги, 4 счетчика страничных
+        // отказов, затем utime и stime
+        if (fgets(buf, sizeof(buf), f) && strstr(buf, "(sleep_worker/") && (p = strrchr(buf, ')')) &&
+            sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) == 2) {
+            ticks += utime + stime;
+        }
+        fclose(f);
+    }
+    closedir(dir);
+    return ticks * BENCH_NSEC_PER_SEC / sysconf(_SC_CLK_TCK);
+}
+
+int main(int argc, char **argv) {
+    const char *dev_path = "/dev/sleep_module";
+    struct bench_samples lat = {0};
+    struct sm_ring_info info;
+    struct updater upd = {0};
+    unsigned long long upd_count = 0, upd_max;
+    int update = 0;
+    struct pollfd pfd;
+    unsigned int duration = 10, jobs = 0, i;
+    uint64_t start, end, now, cpu_ns;
+    unsigned long long iterations;
+    struct sm_ring_ctrl **rings;
+    struct sm_record **recs;
+    int opt, fd;
+
+    while ((opt = getopt(argc, argv, "d:j:u:f:")) != -1) {
+        switch (opt) {
+            case 'd': duration = atoi(optarg); break;
+            case 'j': jobs = atoi(optarg); break;
+            case 'u': update = 1; upd.interval_us = atoi(optarg); break;
+            case 'f': dev_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-j jobs] [-u update_interval_us] [-f device]\n", argv[0]);
+                return 2;
+        }
+    }
+    fd = open(dev_path, O_RDWR); // Управляющая страница отображается на запись
+    if (fd < 0 || ioctl(fd, SM_IOC_RING_INFO, &info)) {
+        perror(dev_path);
+        return 1;
+    }
+    rings = calloc(info.rings, sizeof(*rings));
+    recs = calloc(info.rings, sizeof(*recs));
+    for (i = 0; i < info.rings; i++) {
+        // Читатель пишет tail на управляющей странице; записи отображаются только на чтение
+        rings[i] = mmap(NULL, info.data_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, i * info.map_size);
+        recs[i] = mmap(NULL, info.map_size - info.data_offset, PROT_READ, MAP_SHARED, fd,
+                       i * info.map_size + info.data_offset);
+        if (rings[i] == MAP_FAILED || recs[i] == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+    }
+    if (jobs && add_jobs(jobs)) {
+        return 1;
+    }
+    bench_write_str(SYSFS "reset", "1");
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    cpu_ns = workers_cpu_ns();
+    start = bench_now_ns();
+    if (update) {
+        upd.period_ns = bench_read_ull(PARAMS "period_ns");
+        if (!upd.period_ns) {
+            fprintf(stderr, "-u needs the module loaded with period_ns\n");
+            return 2;
+        }
+        read_update_ns(&upd_count, &upd_max);
+        pthread_create(&upd.thread, NULL, updater_fn, &upd);
+    }
+    do {
+        poll(&pfd, 1, 100);
+        now = bench_now_ns();
+        for (i = 0; i < info.rings; i++) {
+            struct sm_ring_ctrl *ring = rings[i];
+            uint32_t tail = ring->tail;
+            uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+            for (; tail != head; tail++) {
+                const struct sm_record *r = &recs[i][tail & (info.entries - 1)];
+
+                bench_samples_add(&lat, now > r->time_ns ? now - r->time_ns : 0);
+            }
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        }
+    } while (now - start < duration * BENCH_NSEC_PER_SEC);
+    stop = 1;
+    if (update) {
+        pthread_join(upd.thread, NULL);
+    }
+    end = bench_now_ns();
+    cpu_ns = workers_cpu_ns() - cpu_ns;
+    iterations = bench_read_ull(SYSFS "iterations");
+
+    printf("{\"module\": \"sleep_module\", \"rings\": %u, \"jobs\": %llu, \"duration_s\": %.3f, "
+           "\"messages_per_s\": %.1f, \"dropped\": %llu, \"wakeups\": %llu, \"iterations\": %llu, \"missed\": %llu, "
+           "\"worker_cpu_ns\": %llu, \"worker_cpu_ns_per_iteration\": %.1f, \"mean_jitter_ns\": %llu, \"max_jitter_ns\": %llu, ",
+           info.rings, bench_read_ull(SYSFS "jobs"), (end - start) / 1e9, (double)lat.seen * 1e9 / (end - start),
+           bench_read_ull(SYSFS "dropped"), bench_read_ull(SYSFS "wakeups"), iterations, bench_read_ull(SYSFS "missed"),
+           (unsigned long long)cpu_ns, iterations ? (double)cpu_ns / iterations : 0.0, bench_read_ull(SYSFS "mean_jitter_ns"), bench_read_ull(SYSFS "max_jitter_ns"));
+    bench_samples_json(stdout, "delivery_latency_ns", &lat);
+    if (update) {
+        // Счетчик модуля не сбрасывается через reset, поэтому берется разность
+        unsigned long long count = upd_count;
+
+        read_update_ns(&upd_count, &upd_max);
+        printf(", \"updates_per_s\": %.1f, \"module_updates\": %llu, \"module_update_max_ns\": %llu, ",
+               upd.updates * 1e9 / (end - start), upd_count - count, upd_max);
+        bench_samples_json(stdout, "update_write_ns", &upd.write_ns);
+    }
+    printf("}\n");
+    return upd.failed;
+}
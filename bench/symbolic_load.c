@@ -0,0 +1,190 @@
+// Генератор нагрузки symbolic_driver:
+//  - задержка уведомления: ожидание изменения value в poll() при заданном периоде таймера;
+//  - нагрузочная проверка управления: потоки одновременно пишут start/stop/reset, после чего
+//    проверяется, что остановленный таймер не увеличивает value, а запущенный - увеличивает
+//    с ожидаемой скоростью;
+//  - стоимость полного снимка виртуальных счетчиков через mmap() и read() (если counters > 0)
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "symbolic_driver.h"
+
+#define SYSFS "/sys/kernel/symbolic_driver/"
+
+static volatile int stop; // Конец нагрузочной проверки
+static volatile unsigned long long sink; // Сумма снимка, чтобы чтение значений не было удалено
+
+// Чтение value с начала файла
+static unsigned long long read_value(int fd) {
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+    return strtoull(buf, NULL, 10);
+}
+
+// Интервал между уведомлениями минус период
+static void measure_notify(unsigned int duration, uint64_t period_ns, struct bench_samples *jitter) {
+    int fd = open(SYSFS "value", O_RDONLY);
+    struct pollfd pfd = { .fd = fd, .events = POLLPRI | POLLERR };
+    uint64_t start, prev = 0, now;
+
+    read_value(fd);
+    bench_write_str(SYSFS "start", "1");
+    start = bench_now_ns();
+    do {
+        if (poll(&pfd, 1, 1000) <= 0) {
+            break;
+        }
+        now = bench_now_ns();
+        read_value(fd); // Подтверждение уведомления
+        if (prev) {
+            bench_samples_add(jitter, now - prev > period_ns ? now - prev - period_ns : period_ns - (now - prev));
+        }
+        prev = now;
+    } while (now - start < duration * BENCH_NSEC_PER_SEC);
+    bench_write_str(SYSFS "stop", "1");
+    close(fd);
+}
+
+static void *control_fn(void *arg) {
+    static const char *files[] = { SYSFS "start", SYSFS "stop", SYSFS "reset" };
+    unsigned long long *ops = arg;
+    int fds[3], i;
+
+    for (i = 0; i < 3; i++) {
+        fds[i] = open(files[i], O_WRONLY);
+    }
+    while (!stop) {
+        for (i = 0; i < 3; i++) {
+            if (pwrite(fds[i], "1", 1, 0) == 1) {
+                (*ops)++;
+            }
+        }
+    }
+    for (i = 0; i < 3; i++) {
+        close(fds[i]);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    unsigned int duration = 5, threads = 16, i, scrapes = 1000;
+    uint64_t period_ns = 100000, t0;
+    struct bench_samples jitter = {0}, scrape_mmap = {0}, scrape_read = {0};
+    unsigned long long ops = 0, *thread_ops, a, b, rate;
+    char period[32];
+    pthread_t *tids;
+    struct stat st;
+    int opt, fd, stopped_ok;
+
+    while ((opt = getopt(argc, argv, "d:p:t:s:")) != -1) {
+        switch (opt) {
+            case 'd': duration = atoi(optarg); break;
+            case 'p': period_ns = strtoull(optarg, NULL, 0); break;
+            case 't': threads = atoi(optarg); break;
+            case 's': scrapes = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-p period_ns] [-t threads] [-s scrapes]\n", argv[0]);
+                return 2;
+        }
+    }
+    snprintf(period, sizeof(period), "%llu", (unsigned long long)period_ns);
+    if (bench_write_str(SYSFS "period_ns", period)) {
+        return 1;
+    }
+
+    measure_notify(duration, period_ns, &jitter);
+
+    // Нагрузочная проверка управления
+    tids = calloc(threads, sizeof(*tids));
+    thread_ops = calloc(threads, sizeof(*thread_ops));
+    for (i = 0; i < threads; i++) {
+        pthread_create(&tids[i], NULL, control_fn, &thread_ops[i]);
+    }
+    sleep(duration);
+    stop = 1;
+    for (i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        ops += thread_ops[i];
+    }
+    bench_write_str(SYSFS "stop", "1");
+    fd = open(SYSFS "value", O_RDONLY);
+    a = read_value(fd);
+    usleep(10 * period_ns / 1000 + 100000);
+    b = read_value(fd);
+    stopped_ok = a == b && bench_read_ull(SYSFS "running") == 0;
+
+    bench_write_str(SYSFS "reset", "1");
+    bench_write_str(SYSFS "start", "1");
+    sleep(1);
+    rate = read_value(fd);
+    bench_write_str(SYSFS "stop", "1");
+    close(fd);
+
+    // Снимок виртуальных счетчиков
+    if (!stat(SYSFS "counters", &st) && st.st_size) {
+        char *buf = malloc(st.st_size);
+
+        fd = open(SYSFS "counters", O_RDONLY);
+        for (i = 0; i < scrapes; i++) {
+            const struct symbolic_counters_hdr *h;
+            unsigned long long sum;
+            uint32_t seq, n;
+            ssize_t r, done;
+
+            // mmap() и согласованное чтение всех значений
+            t0 = bench_now_ns();
+            h = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (h == MAP_FAILED) {
+                perror("mmap");
+                break;
+            }
+            do {
+                seq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+                sum = 0;
+                for (n = 0; n < h->nr; n++) {
+                    sum += ((const uint64_t *)((const char *)h + h->data_offset))[n];
+                }
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            } while ((seq & 1) || seq != __atomic_load_n(&h->seq, __ATOMIC_RELAXED));
+            munmap((void *)h, st.st_size);
+            sink = sum;
+            bench_samples_add(&scrape_mmap, bench_now_ns() - t0);
+
+            // read() всего файла
+            t0 = bench_now_ns();
+            for (done = 0; done < st.st_size; done += r) {
+                r = pread(fd, buf + done, st.st_size - done, done);
+                if (r <= 0) {
+                    break;
+                }
+            }
+            bench_samples_add(&scrape_read, bench_now_ns() - t0);
+        }
+        close(fd);
+        free(buf);
+    }
+
+    printf("{\"module\": \"symbolic_driver\", \"period_ns\": %llu, ", (unsigned long long)period_ns);
+    bench_samples_json(stdout, "notify_jitter_ns", &jitter);
+    printf(", \"stress\": {\"threads\": %u, \"ops_per_s\": %.0f, \"stopped_ok\": %s, \"rate_per_s\": %llu, "
+           "\"expected_rate_per_s\": %llu}, ", threads, (double)ops / duration, stopped_ok ? "true" : "false",
+           rate, (unsigned long long)(BENCH_NSEC_PER_SEC / period_ns));
+    bench_samples_json(stdout, "scrape_mmap_ns", &scrape_mmap);
+    printf(", ");
+    bench_samples_json(stdout, "scrape_read_ns", &scrape_read);
+    printf("}\n");
+    return stopped_ok ? 0 : 1;
+}
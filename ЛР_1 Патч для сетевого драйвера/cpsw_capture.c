@@ -0,0 +1,584 @@
+#include <linux/kernel.h>    // Для использования функций ядра
+#include <linux/module.h>    // Основные заголовки модуля
+#include <linux/percpu.h>    // Для колец процессоров
+#include <linux/vmalloc.h>   // Для колец, отображаемых в пользовательское пространство
+#include <linux/mm.h>        // Для mmap()
+#include <linux/version.h>   // Для изменения флагов отображения
+#include <linux/debugfs.h>   // Для файлов управления и чтения колец
+#include <linux/uaccess.h>   // Для копирования записей в пользовательскую область
+#include <linux/mutex.h>     // Для сериализации читателей
+#include <linux/log2.h>      // Для проверки емкости кольца
+#include <linux/ktime.h>     // Для временных меток
+#include <linux/filter.h>    // Для классических программ BPF
+#include <linux/if_ether.h>  // Для разбора заголовков пакета
+#include <linux/if_vlan.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/in.h>
+#include <linux/rcupdate.h>  // Для замены фильтра без блокировки захвата
+
+#include "cpsw_capture.h"    // Формат колец и интерфейс захвата
+
+// Захват событий драйвера без printk: каждое событие - запись фиксированного размера в кольцо
+// своего процессора. Запись выполняется с выключенными прерываниями, поэтому у кольца один
+// писатель и блокировки между процессорами не нужны
+
+static unsigned int cap_entries = 8192; // Емкость кольца процессора
+module_param(cap_entries, uint, S_IRUGO);
+MODULE_PARM_DESC(cap_entries, "Емкость кольца захвата процессора (степень двойки)");
+
+// Проверки фильтра
+#define CAP_F_LEN       0x1 // Длина пакета в диапазоне min_len..max_len
+#define CAP_F_ETHERTYPE 0x2 // EtherType (после одного тега VLAN)
+#define CAP_F_PROTO     0x4 // Протокол IPv4/IPv6
+#define CAP_F_PORT      0x8 // Порт источника или назначения TCP/UDP/SCTP
+
+// Фильтр захвата, собранный из описания в debugfs cpsw_capture/filter: проверяется до записи,
+// дешевые проверки выполняются первыми. Заменяется целиком через RCU
+struct cap_filter {
+    u32 flags;              // Выполняемые проверки (CAP_F_*)
+    __be16 ethertype;       // EtherType
+    __be16 port;            // Порт
+    u8 proto;               // Протокол IP
+    u32 min_len;            // Наименьшая длина пакета
+    u32 max_len;            // Наибольшая длина пакета
+    u32 sample;             // Запись одного из sample совпавших пакетов (0 и 1 - всех)
+    u32 snaplen;            // Наибольшее количество захватываемых байт
+    struct bpf_prog *prog;  // Необязательная классическая программа BPF (данные с заголовка Ethernet)
+};
+
+// Кольцо процессора
+struct cpsw_cap_cpu {
+    struct cpsw_cap_ring *ring; // Управляющая страница и записи (vmalloc_user)
+    u32 head;                   // Индекс записи; на страницу публикуется копия
+    u64 dropped;                // Количество отброшенных записей; на страницу публикуется копия
+    u32 sample_count;           // Счетчик прореживания
+    u64 filtered;               // Количество отклоненных фильтром пакетов
+    struct mutex read_lock;     // Сериализация читателей read()
+};
+
+DEFINE_STATIC_KEY_FALSE(cpsw_cap_enabled);
+static DEFINE_PER_CPU(struct cpsw_cap_cpu, cap_cpus);
+static size_t cap_map_size;          // Размер области кольца
+static struct dentry *cap_dir;       // Каталог debugfs cpsw_capture
+static struct cap_filter __rcu *cap_filter; // Текущий фильтр (NULL - захват всех пакетов)
+static DEFINE_MUTEX(cap_filter_lock);  // Сериализация замены фильтра
+
+static struct cpsw_cap_record *cap_record(struct cpsw_cap_ring *ring, u32 idx) {
+    return (struct cpsw_cap_record *)((char *)ring + PAGE_SIZE) + (idx & (cap_entries - 1));
+}
+
+// Резервирование записи в кольце текущего процессора; вызывается с выключенными прерываниями
+static struct cpsw_cap_record *cap_reserve(struct cpsw_cap_cpu *cc) {
+    struct cpsw_cap_ring *ring = cc->ring;
+
+    if (cc->head - smp_load_acquire(&ring->tail) >= cap_entries) {
+        WRITE_ONCE(cc->dropped, cc->dropped + 1); // Кольцо заполнено
+        WRITE_ONCE(ring->dropped, cc->dropped);
+        return NULL;
+    }
+    return cap_record(ring, cc->head);
+}
+
+// Публикация записи читателям read() (индекс модуля) и mmap() (копия на странице)
+static void cap_commit(struct cpsw_cap_cpu *cc) {
+    u32 head = cc->head + 1;
+
+    smp_store_release(&cc->head, head);
+    smp_store_release(&cc->ring->head, head);
+}
+
+// Проверка пакета фильтром; skb->data указывает на заголовок Ethernet
+static bool cap_match(const struct cap_filter *f, const struct sk_buff *skb) {
+    unsigned int off = ETH_HLEN, l4off;
+    struct vlan_hdr _vlan, *vlan;
+    struct ethhdr _eth, *eth;
+    __be16 _ports[2], *ports;
+    __be16 proto;
+    u8 l4proto;
+
+    if ((f->flags & CAP_F_LEN) && (skb->len < f->min_len || skb->len > f->max_len)) {
+        return false;
+    }
+    if (f->flags & (CAP_F_ETHERTYPE | CAP_F_PROTO | CAP_F_PORT)) {
+        eth = skb_header_pointer(skb, 0, sizeof(_eth), &_eth);
+        if (!eth) {
+            return false;
+        }
+        proto = eth->h_proto;
+        if (proto == htons(ETH_P_8021Q)) {
+            vlan = skb_header_pointer(skb, off, sizeof(_vlan), &_vlan);
+            if (!vlan) {
+                return false;
+            }
+            proto = vlan->h_vlan_encapsulated_proto;
+            off += VLAN_HLEN;
+        }
+        if ((f->flags & CAP_F_ETHERTYPE) && proto != f->ethertype) {
+            return false;
+        }
+    }
+    if (f->flags & (CAP_F_PROTO | CAP_F_PORT)) {
+        if (proto == htons(ETH_P_IP)) {
+            struct iphdr _iph, *iph = skb_header_pointer(skb, off, sizeof(_iph), &_iph);
+
+            if (!iph) {
+                return false;
+            }
+            l4proto = iph->protocol;
+            l4off = off + iph->ihl * 4;
+            if ((f->flags & CAP_F_PORT) && (iph->frag_off & htons(IP_OFFSET))) {
+                return false; // Во фрагментах после первого портов нет
+            }
+        } else if (proto == htons(ETH_P_IPV6)) {
+            struct ipv6hdr _ip6h, *ip6h = skb_header_pointer(skb, off, sizeof(_ip6h), &_ip6h);
+
+            if (!ip6h) {
+                return false;
+            }
+            l4proto = ip6h->nexthdr; // Заголовки расширения не разбираются
+            l4off = off + sizeof(*ip6h);
+        } else {
+            return false;
+        }
+        if ((f->flags & CAP_F_PROTO) && l4proto != f->proto) {
+            return false;
+        }
+        if (f->flags & CAP_F_PORT) {
+            if (l4proto != IPPROTO_TCP && l4proto != IPPROTO_UDP &&
+                l4proto != IPPROTO_SCTP && l4proto != IPPROTO_UDPLITE) {
+                return false;
+            }
+            ports = skb_header_pointer(skb, l4off, sizeof(_ports), _ports);
+            if (!ports || (ports[0] != f->port && ports[1] != f->port)) {
+                return false;
+            }
+        }
+    }
+    if (f->prog && !bpf_prog_run_save_cb(f->prog, (struct sk_buff *)skb)) {
+        return false;
+    }
+    return true;
+}
+
+void __cpsw_cap_packet(u8 dir, u8 queue, const struct sk_buff *skb) {
+    unsigned int caplen = CPSW_CAP_HDR_BYTES;
+    struct cpsw_cap_record *rec;
+    const struct cap_filter *f;
+    struct cpsw_cap_cpu *cc;
+    unsigned long flags;
+
+    local_irq_save(flags);
+    cc = this_cpu_ptr(&cap_cpus);
+    rcu_read_lock();
+    f = rcu_dereference(cap_filter);
+    if (f) {
+        if (!cap_match(f, skb)) {
+            cc->filtered++;
+            rcu_read_unlock();
+            local_irq_restore(flags);
+            return;
+        }
+        // Прореживание: записывается каждый sample-й совпавший пакет
+        if (f->sample > 1 && ++cc->sample_count < f->sample) {
+            rcu_read_unlock();
+            local_irq_restore(flags);
+            return;
+        }
+        cc->sample_count = 0;
+        caplen = min(caplen, f->snaplen);
+    }
+    rcu_read_unlock();
+
+    rec = cap_reserve(cc);
+    if (rec) {
+        caplen = min_t(unsigned int, skb->len, caplen);
+        if (skb_copy_bits(skb, 0, rec->data, caplen)) {
+            caplen = 0;
+        }
+        rec->time_ns = ktime_get_ns();
+        rec->len = skb->len;
+        rec->caplen = caplen;
+        rec->dir = dir;
+        rec->queue = queue;
+        rec->irq = -1;
+        rec->cpu = smp_processor_id();
+        cap_commit(cc);
+    }
+    local_irq_restore(flags);
+}
+EXPORT_SYMBOL_GPL(__cpsw_cap_packet);
+
+void __cpsw_cap_irq(int irq) {
+    struct cpsw_cap_record *rec;
+    struct cpsw_cap_cpu *cc;
+    unsigned long flags;
+
+    local_irq_save(flags);
+    cc = this_cpu_ptr(&cap_cpus);
+    rec = cap_reserve(cc);
+    if (rec) {
+        rec->time_ns = ktime_get_ns();
+        rec->len = 0;
+        rec->caplen = 0;
+        rec->dir = CPSW_CAP_IRQ;
+        rec->queue = 0;
+        rec->irq = irq;
+        rec->cpu = smp_processor_id();
+        cap_commit(cc);
+    }
+    local_irq_restore(flags);
+}
+EXPORT_SYMBOL_GPL(__cpsw_cap_irq);
+
+// Чтение целых записей кольца процессора (файл cpuN). Файл создан без прокси debugfs
+// (прокси не передает mmap), поэтому удаление файла и освобождение кольца ждут
+// debugfs_file_put()
+static ssize_t cap_cpu_read(struct file *file, char __user *buf, size_t count, loff_t *ppos) {
+    struct cpsw_cap_cpu *cc = per_cpu_ptr(&cap_cpus, (long)file->private_data);
+    struct cpsw_cap_ring *ring;
+    size_t copied = 0;
+    u32 tail, head;
+    int ret;
+
+    if (count < sizeof(struct cpsw_cap_record)) {
+        return -EINVAL; // Буфер должен вмещать запись
+    }
+    ret = debugfs_file_get(file->f_path.dentry);
+    if (ret) {
+        return ret; // Захват удален
+    }
+    ring = cc->ring;
+    mutex_lock(&cc->read_lock);
+    head = smp_load_acquire(&cc->head); // Записи до head опубликованы
+    tail = READ_ONCE(ring->tail);
+    if (head - tail > cap_entries) {
+        tail = head - cap_entries; // tail доступен на запись через mmap()
+    }
+    while (tail != head && copied + sizeof(struct cpsw_cap_record) <= count) {
+        if (copy_to_user(buf + copied, cap_record(ring, tail), sizeof(struct cpsw_cap_record))) {
+            break;
+        }
+        copied += sizeof(struct cpsw_cap_record);
+        tail++;
+    }
+    smp_store_release(&ring->tail, tail); // Освобождение записей для писателя
+    mutex_unlock(&cc->read_lock);
+    debugfs_file_put(file->f_path.dentry);
+    return copied ? copied : (tail != head ? -EFAULT : 0);
+}
+
+// Отображение кольца процессора: управляющая страница и записи. На запись отображается только
+// управляющая страница (индекс tail), записи - только на чтение. Отображенные страницы
+// удерживаются и после освобождения кольца
+static int cap_cpu_mmap(struct file *file, struct vm_area_struct *vma) {
+    struct cpsw_cap_cpu *cc = per_cpu_ptr(&cap_cpus, (long)file->private_data);
+    unsigned long first = vma->vm_pgoff, size = vma->vm_end - vma->vm_start;
+    int ret;
+
+    if (first > 1 || size > cap_map_size - (first << PAGE_SHIFT)) {
+        return -EINVAL;
+    }
+    if (first || size > PAGE_SIZE) {
+        // Отображение захватывает записи: запись запрещена, и mprotect() ее не разрешит
+        if (vma->vm_flags & VM_WRITE) {
+            return -EPERM;
+        }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+        vm_flags_clear(vma, VM_MAYWRITE);
+#else
+        vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    }
+    ret = debugfs_file_get(file->f_path.dentry);
+    if (ret) {
+        return ret;
+    }
+    ret = remap_vmalloc_range(vma, cc->ring, first);
+    debugfs_file_put(file->f_path.dentry);
+    return ret;
+}
+
+static const struct file_operations cap_cpu_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .read = cap_cpu_read,
+    .mmap = cap_cpu_mmap,
+    .llseek = no_llseek,
+};
+
+// Включение и выключение захвата
+static int cap_enable_get(void *data, u64 *val) {
+    *val = static_key_enabled(&cpsw_cap_enabled);
+    return 0;
+}
+
+static int cap_enable_set(void *data, u64 val) {
+    if (val) {
+        static_branch_enable(&cpsw_cap_enabled);
+    } else {
+        static_branch_disable(&cpsw_cap_enabled);
+    }
+    return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(cap_enable_fops, cap_enable_get, cap_enable_set, "%llu\n");
+
+// Сумма отброшенных записей всех процессоров
+static int cap_dropped_get(void *data, u64 *val) {
+    unsigned int cpu;
+
+    *val = 0;
+    for_each_possible_cpu(cpu) {
+        *val += READ_ONCE(per_cpu(cap_cpus, cpu).dropped);
+    }
+    return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(cap_dropped_fops, cap_dropped_get, NULL, "%llu\n");
+
+// Сумма отклоненных фильтром пакетов всех процессоров
+static int cap_filtered_get(void *data, u64 *val) {
+    unsigned int cpu;
+
+    *val = 0;
+    for_each_possible_cpu(cpu) {
+        *val += READ_ONCE(per_cpu(cap_cpus, cpu).filtered);
+    }
+    return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(cap_filtered_fops, cap_filtered_get, NULL, "%llu\n");
+
+// Установка фильтра и освобождение предыдущего после завершения текущих проверок
+static void cap_filter_replace(struct cap_filter *nf) {
+    struct cap_filter *old;
+
+    old = rcu_replace_pointer(cap_filter, nf, lockdep_is_held(&cap_filter_lock));
+    if (old) {
+        synchronize_rcu();
+        if (old->prog && (!nf || nf->prog != old->prog)) {
+            bpf_prog_destroy(old->prog);
+        }
+        kfree(old);
+    }
+}
+
+// Разбор описания фильтра: "ethertype=0x0800 proto=17 port=53 len=64-1500 sample=100 snaplen=64".
+// Новое описание заменяет прежние проверки, программа BPF сохраняется
+static int cap_filter_parse(char *spec, struct cap_filter *f) {
+    char *tok, *val;
+    u32 a, b;
+    u16 v16;
+    int ret;
+
+    f->snaplen = CPSW_CAP_HDR_BYTES;
+    while ((tok = strsep(&spec, " \t\n")) != NULL) {
+        if (!*tok) {
+            continue;
+        }
+        val = strchr(tok, '=');
+        if (!val) {
+            return -EINVAL;
+        }
+        *val++ = '\0';
+        if (!strcmp(tok, "ethertype")) {
+            ret = kstrtou16(val, 0, &v16);
+            f->ethertype = htons(v16);
+            f->flags |= CAP_F_ETHERTYPE;
+        } else if (!strcmp(tok, "proto")) {
+            ret = kstrtou8(val, 0, &f->proto);
+            f->flags |= CAP_F_PROTO;
+        } else if (!strcmp(tok, "port")) {
+            ret = kstrtou16(val, 0, &v16);
+            f->port = htons(v16);
+            f->flags |= CAP_F_PORT;
+        } else if (!strcmp(tok, "len")) {
+            ret = sscanf(val, "%u-%u", &a, &b) == 2 && a <= b ? 0 : -EINVAL;
+            f->min_len = a;
+            f->max_len = b;
+            f->flags |= CAP_F_LEN;
+        } else if (!strcmp(tok, "sample")) {
+            ret = kstrtou32(val, 0, &f->sample);
+        } else if (!strcmp(tok, "snaplen")) {
+            ret = kstrtou32(val, 0, &f->snaplen);
+        } else {
+            ret = -EINVAL;
+        }
+        if (ret) {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+static ssize_t cap_filter_write(struct file *file, const char __user *ubuf, size_t count, loff_t *ppos) {
+    struct cap_filter *nf, *cur;
+    bool clear;
+    char *spec;
+    int ret;
+
+    if (count > 256) {
+        return -EINVAL;
+    }
+    spec = memdup_user_nul(ubuf, count);
+    if (IS_ERR(spec)) {
+        return PTR_ERR(spec);
+    }
+    nf = kzalloc(sizeof(*nf), GFP_KERNEL);
+    if (!nf) {
+        kfree(spec);
+        return -ENOMEM;
+    }
+    clear = sysfs_streq(spec, "clear"); // Снятие фильтра вместе с программой BPF
+    ret = clear ? 0 : cap_filter_parse(spec, nf);
+    kfree(spec);
+    if (ret) {
+        kfree(nf);
+        return ret;
+    }
+
+    mutex_lock(&cap_filter_lock);
+    cur = rcu_dereference_protected(cap_filter, lockdep_is_held(&cap_filter_lock));
+    if (cur && !clear) {
+        nf->prog = cur->prog; // Программа BPF переходит к новому фильтру
+    }
+    if (!nf->snaplen) {
+        nf->snaplen = CPSW_CAP_HDR_BYTES;
+    }
+    if (clear || (!nf->flags && nf->sample <= 1 && nf->snaplen >= CPSW_CAP_HDR_BYTES && !nf->prog)) {
+        kfree(nf); // Фильтр ничего не отбирает - захват всех пакетов без проверок
+        nf = NULL;
+    }
+    cap_filter_replace(nf);
+    mutex_unlock(&cap_filter_lock);
+    return count;
+}
+
+static ssize_t cap_filter_read(struct file *file, char __user *ubuf, size_t count, loff_t *ppos) {
+    const struct cap_filter *f;
+    char buf[160];
+    int len;
+
+    mutex_lock(&cap_filter_lock);
+    f = rcu_dereference_protected(cap_filter, lockdep_is_held(&cap_filter_lock));
+    if (!f) {
+        len = scnprintf(buf, sizeof(buf), "none\n");
+    } else {
+        len = scnprintf(buf, sizeof(buf), "flags=0x%x ethertype=0x%04x proto=%u port=%u len=%u-%u sample=%u snaplen=%u bpf=%u\n",
+                        f->flags, ntohs(f->ethertype), f->proto, ntohs(f->port), f->min_len, f->max_len,
+                        f->sample, f->snaplen, f->prog ? f->prog->len : 0);
+    }
+    mutex_unlock(&cap_filter_lock);
+    return simple_read_from_buffer(ubuf, count, ppos, buf, len);
+}
+
+static const struct file_operations cap_filter_fops = {
+    .owner = THIS_MODULE,
+    .read = cap_filter_read,
+    .write = cap_filter_write,
+    .llseek = default_llseek,
+};
+
+// Установка классической программы BPF: массив struct sock_filter (вывод tcpdump -dd)
+static ssize_t cap_bpf_write(struct file *file, const char __user *ubuf, size_t count, loff_t *ppos) {
+    struct sock_fprog_kern fprog;
+    struct cap_filter *nf, *cur;
+    struct bpf_prog *prog;
+    void *insns;
+    int ret;
+
+    if (!count || count % sizeof(struct sock_filter) || count > BPF_MAXINSNS * sizeof(struct sock_filter)) {
+        return -EINVAL;
+    }
+    insns = memdup_user(ubuf, count);
+    if (IS_ERR(insns)) {
+        return PTR_ERR(insns);
+    }
+    fprog.len = count / sizeof(struct sock_filter);
+    fprog.filter = insns;
+    ret = bpf_prog_create(&prog, &fprog); // Проверка и перевод программы
+    kfree(insns);
+    if (ret) {
+        return ret;
+    }
+    nf = kzalloc(sizeof(*nf), GFP_KERNEL);
+    if (!nf) {
+        bpf_prog_destroy(prog);
+        return -ENOMEM;
+    }
+
+    mutex_lock(&cap_filter_lock);
+    cur = rcu_dereference_protected(cap_filter, lockdep_is_held(&cap_filter_lock));
+    if (cur) {
+        *nf = *cur; // Остальные проверки сохраняются; старая программа освобождается с cur
+    } else {
+        nf->snaplen = CPSW_CAP_HDR_BYTES;
+    }
+    nf->prog = prog;
+    cap_filter_replace(nf);
+    mutex_unlock(&cap_filter_lock);
+    return count;
+}
+
+static const struct file_operations cap_bpf_fops = {
+    .owner = THIS_MODULE,
+    .write = cap_bpf_write,
+    .llseek = no_llseek,
+};
+
+void cpsw_cap_exit(void) {
+    unsigned int cpu;
+
+    debugfs_remove_recursive(cap_dir);
+    cap_dir = NULL;
+    static_branch_disable(&cpsw_cap_enabled);
+    mutex_lock(&cap_filter_lock);
+    cap_filter_replace(NULL); // Снятие фильтра
+    mutex_unlock(&cap_filter_lock);
+    synchronize_rcu(); // Завершение записей, начатых с выключенными прерываниями
+    for_each_possible_cpu(cpu) {
+        vfree(per_cpu(cap_cpus, cpu).ring);
+        per_cpu(cap_cpus, cpu).ring = NULL;
+    }
+}
+EXPORT_SYMBOL_GPL(cpsw_cap_exit);
+
+int cpsw_cap_init(void) {
+    unsigned int cpu;
+    char name[16];
+
+    if (!is_power_of_2(cap_entries)) {
+        pr_alert("cap_entries must be a power of two\n");
+        return -EINVAL;
+    }
+    cap_map_size = PAGE_SIZE + PAGE_ALIGN((size_t)cap_entries * sizeof(struct cpsw_cap_record));
+
+    for_each_possible_cpu(cpu) {
+        struct cpsw_cap_cpu *cc = per_cpu_ptr(&cap_cpus, cpu);
+
+        mutex_init(&cc->read_lock);
+        cc->head = 0;
+        cc->dropped = 0;
+        cc->ring = vmalloc_user(cap_map_size); // Обнуленная память, пригодная для mmap()
+        if (!cc->ring) {
+            cpsw_cap_exit();
+            return -ENOMEM;
+        }
+        cc->ring->entries = cap_entries;
+        cc->ring->record_size = sizeof(struct cpsw_cap_record);
+        cc->ring->data_offset = PAGE_SIZE;
+    }
+
+    // Ошибки debugfs не мешают работе драйвера
+    cap_dir = debugfs_create_dir("cpsw_capture", NULL);
+    debugfs_create_file_unsafe("enable", 0600, cap_dir, NULL, &cap_enable_fops);
+    debugfs_create_file_unsafe("dropped", 0400, cap_dir, NULL, &cap_dropped_fops);
+    debugfs_create_file_unsafe("filtered", 0400, cap_dir, NULL, &cap_filtered_fops);
+    debugfs_create_file("filter", 0600, cap_dir, NULL, &cap_filter_fops);
+    debugfs_create_file("bpf", 0200, cap_dir, NULL, &cap_bpf_fops);
+    for_each_possible_cpu(cpu) {
+        snprintf(name, sizeof(name), "cpu%u", cpu);
+        // Прокси debugfs_create_file() не передает mmap; запись нужна для отображения индекса tail
+        debugfs_create_file_unsafe(name, 0600, cap_dir, (void *)(long)cpu, &cap_cpu_fops);
+    }
+    return 0;
+}
+EXPORT_SYMBOL_GPL(cpsw_cap_init);
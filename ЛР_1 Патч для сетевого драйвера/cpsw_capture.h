@@ -0,0 +1,73 @@
+#ifndef CPSW_CAPTURE_H
+#define CPSW_CAPTURE_H
+
+// Захват метаданных пакетов и прерываний драйвера cpsw в кольца процессоров.
+// Формат колец общий для модуля и пользовательских программ
+
+#include <linux/types.h>
+
+#define CPSW_CAP_RING_ALIGN 128 // Индексы записи и чтения находятся в разных кэш-линиях
+#define CPSW_CAP_HDR_BYTES 104  // Наибольшее количество захватываемых байт заголовка
+
+// Тип события
+#define CPSW_CAP_RX 0  // Принятый пакет
+#define CPSW_CAP_TX 1  // Передаваемый пакет
+#define CPSW_CAP_IRQ 2 // Прерывание
+
+// Запись кольца (128 байт)
+struct cpsw_cap_record {
+    __u64 time_ns;                    // Время события (CLOCK_MONOTONIC)
+    __u32 len;                        // Длина пакета
+    __u16 caplen;                     // Количество захваченных байт в data
+    __u8 dir;                         // Тип события (CPSW_CAP_*)
+    __u8 queue;                       // Номер очереди (канала DMA)
+    __s32 irq;                        // Номер прерывания (для CPSW_CAP_IRQ), иначе -1
+    __u32 cpu;                        // Процессор
+    __u8 data[CPSW_CAP_HDR_BYTES];    // Начало пакета с заголовка Ethernet
+};
+
+// Управляющая страница кольца процессора (начало файла cpuN в debugfs); записи - с data_offset.
+// Индексы свободно растут, позиция записи - индекс & (entries - 1). Страница отображается на
+// запись отдельно (длина data_offset), записи и область целиком - только на чтение.
+// Модуль не читает head и dropped со страницы, а tail ограничивает последними entries записями
+struct cpsw_cap_ring {
+    __u32 head;                              // Индекс записи (пишет модуль, release)
+    __u8 pad0[CPSW_CAP_RING_ALIGN - sizeof(__u32)];
+    __u32 tail;                              // Индекс чтения (пишет читатель, release)
+    __u8 pad1[CPSW_CAP_RING_ALIGN - sizeof(__u32)];
+    __u64 dropped;                           // Количество отброшенных при заполнении записей
+    __u32 entries;                           // Емкость кольца (степень двойки)
+    __u32 record_size;                       // Размер struct cpsw_cap_record
+    __u32 data_offset;                       // Смещение записей от начала области
+};
+
+#ifdef __KERNEL__
+
+#include <linux/jump_label.h>
+#include <linux/skbuff.h>
+
+DECLARE_STATIC_KEY_FALSE(cpsw_cap_enabled); // Захват включен (debugfs cpsw_capture/enable)
+
+int cpsw_cap_init(void);  // Выделение колец и создание файлов debugfs
+void cpsw_cap_exit(void); // Удаление файлов debugfs и освобождение колец
+
+void __cpsw_cap_packet(u8 dir, u8 queue, const struct sk_buff *skb);
+void __cpsw_cap_irq(int irq);
+
+// Захват пакета; при выключенном захвате - одна невыполняемая ветка
+static inline void cpsw_cap_packet(u8 dir, u8 queue, const struct sk_buff *skb) {
+    if (static_branch_unlikely(&cpsw_cap_enabled)) {
+        __cpsw_cap_packet(dir, queue, skb);
+    }
+}
+
+// Захват прерывания
+static inline void cpsw_cap_irq(int irq) {
+    if (static_branch_unlikely(&cpsw_cap_enabled)) {
+        __cpsw_cap_irq(irq);
+    }
+}
+
+#endif // __KERNEL__
+
+#endif // CPSW_CAPTURE_H
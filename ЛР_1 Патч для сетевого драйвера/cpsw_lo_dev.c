@@ -0,0 +1,277 @@
+#include <linux/kernel.h>    // Для использования функций ядра
+#include <linux/module.h>    // Основные заголовки модуля
+#include <linux/netdevice.h> // Для работы с сетевыми устройствами
+#include <linux/etherdevice.h> // Для устройств Ethernet
+#include <linux/slab.h>      // Для кольца дескрипторов
+#include <linux/log2.h>      // Для проверки емкости кольца
+#include <linux/ktime.h>     // Для задержки передачи
+#include <linux/debugfs.h>   // Для счетчиков измерений
+
+#include "cpsw_capture.h"    // Захват метаданных пакетов
+
+// Виртуальное устройство cpswlo: заменяет cpsw для измерений без платы BeagleBone Black.
+// Передаваемый пакет проходит те же точки захвата, что и в драйвере, и возвращается на прием.
+// В режиме sdma передача идет через программную модель канала DMA: xmit ставит дескриптор
+// в кольцо, «звонок» (sdma_kick) делается один раз на пачку пакетов, а завершения
+// обрабатываются в NAPI с учетом BQL, как в cpsw
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Виртуальное петлевое устройство для измерения захвата пакетов cpsw");
+
+static bool sdma = true; // Передача через программный канал DMA
+module_param(sdma, bool, S_IRUGO);
+MODULE_PARM_DESC(sdma, "Передача через программную модель канала DMA (0 - сразу на прием)");
+
+static unsigned int sdma_entries = 256; // Количество дескрипторов канала
+module_param(sdma_entries, uint, S_IRUGO);
+MODULE_PARM_DESC(sdma_entries, "Количество дескрипторов программного канала DMA (степень двойки)");
+
+// Дескриптор передачи
+struct sdma_desc {
+    struct sk_buff *skb; // Пакет
+    u64 submit_ns;       // Время постановки в кольцо
+};
+
+// Программный канал DMA. Индексы свободно растут, позиция - индекс & (sdma_entries - 1).
+// head пишет xmit (под блокировкой очереди), kicked - «звонок», до которого канал видит
+// дескрипторы, tail - NAPI после завершения передачи
+struct cpsw_lo_priv {
+    struct napi_struct napi;  // Обработка завершений
+    struct sdma_desc *ring;   // Кольцо дескрипторов
+    u32 head;                 // Следующий свободный дескриптор
+    u32 kicked;               // Граница, переданная каналу (release)
+    u32 tail;                 // Первый незавершенный дескриптор (release)
+    u64 kicks;                // Количество звонков
+    u64 completed;            // Количество завершенных передач
+    u64 lat_sum_ns;           // Сумма задержек от постановки до завершения
+    u64 lat_max_ns;           // Наибольшая задержка
+};
+
+static struct net_device *lo_dev; // Виртуальное устройство
+static struct dentry *lo_dir;     // Каталог debugfs cpsw_lo
+
+// Прием: захват до eth_type_trans(), пока skb->data указывает на заголовок Ethernet
+static void cpsw_lo_receive(struct sk_buff *skb, struct net_device *ndev, bool napi) {
+    unsigned int len = skb->len;
+
+    skb_orphan(skb);
+    skb_dst_drop(skb);
+    cpsw_cap_packet(CPSW_CAP_RX, 0, skb);
+    skb->protocol = eth_type_trans(skb, ndev);
+    if ((napi ? netif_receive_skb(skb) : netif_rx(skb)) == NET_RX_SUCCESS) {
+        dev_sw_netstats_rx_add(ndev, len);
+    }
+}
+
+// Свободных дескрипторов нет
+static bool sdma_full(struct cpsw_lo_priv *priv) {
+    return priv->head - smp_load_acquire(&priv->tail) >= sdma_entries;
+}
+
+// Звонок: канал видит все поставленные дескрипторы
+static void sdma_kick(struct cpsw_lo_priv *priv) {
+    smp_store_release(&priv->kicked, priv->head);
+    priv->kicks++;
+    napi_schedule(&priv->napi);
+}
+
+// Передача через программный канал DMA
+static netdev_tx_t cpsw_lo_sdma_xmit(struct sk_buff *skb, struct net_device *ndev) {
+    struct cpsw_lo_priv *priv = netdev_priv(ndev);
+    struct netdev_queue *txq = netdev_get_tx_queue(ndev, 0);
+    struct sdma_desc *d;
+    unsigned int len = skb->len;
+
+    if (unlikely(sdma_full(priv))) {
+        netif_tx_stop_queue(txq);
+        sdma_kick(priv);
+        return NETDEV_TX_BUSY;
+    }
+    d = &priv->ring[priv->head & (sdma_entries - 1)];
+    d->skb = skb;
+    d->submit_ns = ktime_get_ns();
+    priv->head++;
+
+    // Запись TX только о принятом пакете: при NETDEV_TX_BUSY стек повторит передачу.
+    // Канал увидит дескриптор только после звонка, поэтому skb еще не освобожден
+    cpsw_cap_packet(CPSW_CAP_TX, skb_get_queue_mapping(skb), skb);
+
+    // Кольцо заполнено - очередь останавливается до завершений
+    if (unlikely(sdma_full(priv))) {
+        netif_tx_stop_queue(txq);
+        smp_mb__after_atomic(); // Остановка видна NAPI на других процессорах
+        if (!sdma_full(priv)) {
+            netif_tx_wake_queue(txq);
+        }
+    }
+
+    // BQL; звонок один раз на пачку: когда за пакетом больше ничего нет или очередь остановлена
+    if (__netdev_tx_sent_queue(txq, len, netdev_xmit_more())) {
+        sdma_kick(priv);
+    }
+    return NETDEV_TX_OK;
+}
+
+// Завершение передачи: пакеты канала возвращаются на прием, освобождается место для BQL
+static int cpsw_lo_poll(struct napi_struct *napi, int budget) {
+    struct cpsw_lo_priv *priv = container_of(napi, struct cpsw_lo_priv, napi);
+    struct net_device *ndev = napi->dev;
+    struct netdev_queue *txq = netdev_get_tx_queue(ndev, 0);
+    u32 tail = priv->tail, kicked = smp_load_acquire(&priv->kicked);
+    unsigned int pkts = 0, bytes = 0;
+    u64 now = ktime_get_ns(), lat;
+
+    while (tail != kicked && pkts < budget) {
+        struct sdma_desc *d = &priv->ring[tail & (sdma_entries - 1)];
+        struct sk_buff *skb = d->skb;
+
+        lat = now - d->submit_ns;
+        priv->lat_sum_ns += lat;
+        priv->lat_max_ns = max(priv->lat_max_ns, lat);
+        bytes += skb->len; // До eth_type_trans(): та же длина, что учтена при отправке
+        pkts++;
+        tail++;
+        cpsw_lo_receive(skb, ndev, true);
+    }
+    smp_store_release(&priv->tail, tail); // Освобождение дескрипторов для xmit
+    priv->completed += pkts;
+    dev_sw_netstats_tx_add(ndev, pkts, bytes);
+
+    netdev_tx_completed_queue(txq, pkts, bytes);
+    if (unlikely(netif_tx_queue_stopped(txq)) && !sdma_full(priv)) {
+        netif_tx_wake_queue(txq);
+    }
+
+    if (pkts < budget && napi_complete_done(napi, pkts)) {
+        // Звонок мог прийти после проверки
+        if (smp_load_acquire(&priv->kicked) != tail) {
+            napi_schedule(napi);
+        }
+    }
+    return pkts;
+}
+
+// Передача пакета: канал DMA или сразу прием; захват TX - после того, как пакет принят
+static netdev_tx_t cpsw_lo_start_xmit(struct sk_buff *skb, struct net_device *ndev) {
+    skb_tx_timestamp(skb); // Устанавливаем временную метку для пакета
+
+    if (sdma) {
+        return cpsw_lo_sdma_xmit(skb, ndev);
+    }
+    cpsw_cap_packet(CPSW_CAP_TX, skb_get_queue_mapping(skb), skb);
+    dev_sw_netstats_tx_add(ndev, 1, skb->len);
+    cpsw_lo_receive(skb, ndev, false);
+    return NETDEV_TX_OK;
+}
+
+// Счетчики пакетов процессоров и канал DMA
+static int cpsw_lo_dev_init(struct net_device *ndev) {
+    struct cpsw_lo_priv *priv = netdev_priv(ndev);
+
+    ndev->tstats = netdev_alloc_pcpu_stats(struct pcpu_sw_netstats);
+    if (!ndev->tstats) {
+        return -ENOMEM;
+    }
+    priv->ring = kcalloc(sdma_entries, sizeof(*priv->ring), GFP_KERNEL);
+    if (!priv->ring) {
+        free_percpu(ndev->tstats);
+        return -ENOMEM;
+    }
+    netif_napi_add(ndev, &priv->napi, cpsw_lo_poll);
+    return 0;
+}
+
+static void cpsw_lo_dev_uninit(struct net_device *ndev) {
+    struct cpsw_lo_priv *priv = netdev_priv(ndev);
+
+    netif_napi_del(&priv->napi);
+    kfree(priv->ring);
+    free_percpu(ndev->tstats);
+}
+
+static int cpsw_lo_open(struct net_device *ndev) {
+    struct cpsw_lo_priv *priv = netdev_priv(ndev);
+
+    priv->head = priv->kicked = priv->tail = 0;
+    netdev_tx_reset_queue(netdev_get_tx_queue(ndev, 0)); // Начинаем учет BQL с пустой очереди
+    napi_enable(&priv->napi);
+    netif_start_queue(ndev);
+    return 0;
+}
+
+static int cpsw_lo_stop(struct net_device *ndev) {
+    struct cpsw_lo_priv *priv = netdev_priv(ndev);
+
+    netif_stop_queue(ndev);
+    napi_disable(&priv->napi);
+    // Пакеты, не переданные каналом, отбрасываются
+    for (; priv->tail != priv->head; priv->tail++) {
+        dev_kfree_skb_any(priv->ring[priv->tail & (sdma_entries - 1)].skb);
+    }
+    netdev_tx_reset_queue(netdev_get_tx_queue(ndev, 0));
+    return 0;
+}
+
+static const struct net_device_ops cpsw_lo_netdev_ops = {
+    .ndo_init = cpsw_lo_dev_init,
+    .ndo_uninit = cpsw_lo_dev_uninit,
+    .ndo_open = cpsw_lo_open,
+    .ndo_stop = cpsw_lo_stop,
+    .ndo_start_xmit = cpsw_lo_start_xmit,
+    .ndo_get_stats64 = dev_get_tstats64,
+    .ndo_set_mac_address = eth_mac_addr,
+    .ndo_validate_addr = eth_validate_addr,
+};
+
+static void cpsw_lo_setup(struct net_device *ndev) {
+    ether_setup(ndev);
+    ndev->netdev_ops = &cpsw_lo_netdev_ops;
+    ndev->needs_free_netdev = true;
+    ndev->flags |= IFF_NOARP;
+    ndev->priv_flags |= IFF_LIVE_ADDR_CHANGE;
+    eth_hw_addr_random(ndev);
+}
+
+// Счетчики канала DMA: количество звонков и завершений, задержка передачи
+static void cpsw_lo_debugfs_init(struct cpsw_lo_priv *priv) {
+    lo_dir = debugfs_create_dir("cpsw_lo", NULL);
+    debugfs_create_u64("kicks", 0400, lo_dir, &priv->kicks);
+    debugfs_create_u64("completed", 0400, lo_dir, &priv->completed);
+    debugfs_create_u64("lat_sum_ns", 0400, lo_dir, &priv->lat_sum_ns);
+    debugfs_create_u64("lat_max_ns", 0400, lo_dir, &priv->lat_max_ns);
+}
+
+static int __init cpsw_lo_init(void) {
+    int ret;
+
+    if (!is_power_of_2(sdma_entries)) {
+        pr_alert("sdma_entries must be a power of two\n");
+        return -EINVAL;
+    }
+    ret = cpsw_cap_init();
+    if (ret) {
+        return ret;
+    }
+    lo_dev = alloc_netdev(sizeof(struct cpsw_lo_priv), "cpswlo%d", NET_NAME_ENUM, cpsw_lo_setup);
+    if (!lo_dev) {
+        cpsw_cap_exit();
+        return -ENOMEM;
+    }
+    ret = register_netdev(lo_dev);
+    if (ret) {
+        free_netdev(lo_dev);
+        cpsw_cap_exit();
+        return ret;
+    }
+    cpsw_lo_debugfs_init(netdev_priv(lo_dev));
+    return 0;
+}
+
+static void __exit cpsw_lo_exit(void) {
+    debugfs_remove_recursive(lo_dir);
+    unregister_netdev(lo_dev); // Освобождается через needs_free_netdev
+    cpsw_cap_exit();
+}
+
+module_init(cpsw_lo_init);
+module_exit(cpsw_lo_exit);
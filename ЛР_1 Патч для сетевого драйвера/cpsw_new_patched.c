@@ -3,30 +3,33 @@
 #include <linux/netdevice.h> // Для работы с сетевыми устройствами
 #include <linux/interrupt.h> // Для обработки прерываний
 
+#include "cpsw_capture.h"    // Захват метаданных пакетов и прерываний вместо printk
+
 // Обработчик прерываний для входящих пакетов
 static irqreturn_t my_interrupt_handler(int irq, void *dev_id) {
-    struct net_device *dev = dev_id; // Получаем указатель на сетевое устройство
-
-    // Логируем номер прерывания
-    printk(KERN_INFO "Interrupt received: %d\n", irq);
-
-    // Логируем адрес области ввода-вывода
-    printk(KERN_INFO "I/O address: %p\n", dev->base_addr);
-
-    // Логируем размер области ввода-вывода
-    printk(KERN_INFO "I/O area size: %zu\n", sizeof(dev->base_addr));
+    // Запись о прерывании в кольцо процессора; адрес и размер области ввода-вывода
+    // не меняются и выводятся один раз при открытии и остановке устройства
+    cpsw_cap_irq(irq);
 
     return IRQ_HANDLED; // Возвращаем, что прерывание обработано
 }
 
 // Функция обработки входящих пакетов
 static int my_receive_packet(struct sk_buff *skb, struct net_device *dev) {
-    // Логируем содержимое входящего пакета и его размер
-    printk(KERN_INFO "Received packet size: %zu\n", skb->len);
+    // Запись о входящем пакете: размер и начало данных (до eth_type_trans())
+    cpsw_cap_packet(CPSW_CAP_RX, skb_get_rx_queue(skb), skb);
     // Дополнительная логика обработки пакета может быть добавлена здесь
     return 0; // Возвращаем 0 для успешной обработки
 }
 
+// Сброс учета BQL всех очередей передачи: xmit учитывает байты в каждой из них
+static void cpsw_tx_reset_queues(struct net_device *ndev) {
+    unsigned int i;
+
+    for (i = 0; i < ndev->real_num_tx_queues; i++)
+        netdev_tx_reset_queue(netdev_get_tx_queue(ndev, i));
+}
+
 // Функция обработки остановки сетевого устройства
 static int cpsw_ndo_stop(struct net_device *ndev) {
     printk(KERN_INFO "cpsw_ndo_stop called"); // Логируем вызов функции остановки
@@ -35,6 +38,7 @@ static int cpsw_ndo_stop(struct net_device *ndev) {
     struct cpsw_common *cpsw = priv->cpsw; // Получаем общие данные CPSW
     cpsw->usage_count--; // Уменьшаем счетчик использования
 
+    cpsw_tx_reset_queues(ndev); // Сбрасываем учет BQL очередей
     pm_runtime_put_sync(cpsw->dev); // Освобождаем ресурсы
 
     // Логируем информацию об области ввода-вывода
@@ -50,28 +54,139 @@ static int cpsw_ndo_open(struct net_device *ndev) {
     struct cpsw_common *cpsw = priv->cpsw; // Получаем общие данные CPSW
     int ret;
 
+    // Логируем информацию об области ввода-вывода
+    printk(KERN_INFO "IO region: %lx, size: %d\n", ndev->base_addr, ndev->mem_end - ndev->base_addr);
+
     // Дополнительная логика открытия устройства может быть добавлена здесь
+    cpsw_tx_reset_queues(ndev); // Начинаем учет BQL с пустых очередей
     return 0; // Возвращаем 0 для успешного открытия
 }
 
+// Завершения передачи, накопленные за вызов NAPI: BQL обновляется один раз на очередь за
+// вызов, а не на каждый пакет. Завершения подряд обычно относятся к одной очереди, смена
+// очереди (другой канал или порт) сбрасывает накопленное
+struct cpsw_tx_batch {
+    struct netdev_queue *txq; // Очередь накопленных завершений
+    unsigned int pkts;        // Количество пакетов
+    unsigned int bytes;       // Количество байт (длины при отправке)
+};
+
+static DEFINE_PER_CPU(struct cpsw_tx_batch, cpsw_tx_batch);
+
+static void cpsw_tx_batch_flush(struct cpsw_tx_batch *b) {
+    if (!b->pkts)
+        return;
+    netdev_tx_completed_queue(b->txq, b->pkts, b->bytes); // BQL: освобождаем место в очереди
+    if (unlikely(netif_tx_queue_stopped(b->txq)))
+        netif_tx_wake_queue(b->txq);
+    b->pkts = 0;
+    b->bytes = 0;
+}
+
+// Завершение передачи пакета (обратный вызов канала DMA из NAPI)
+static void cpsw_tx_handler(void *token, int len, int status) {
+    struct sk_buff *skb = token; // Переданный пакет
+    struct net_device *ndev = skb->dev;
+    // xmit записал в skb номер очереди, в которой учтен пакет
+    struct netdev_queue *txq = netdev_get_tx_queue(ndev, skb_get_queue_mapping(skb));
+    unsigned int bytes = skb->len; // Учитывается та же длина, что при отправке
+    struct cpsw_tx_batch *b;
+
+    // Снятие дескриптора при остановке канала (вне NAPI): учет BQL сбрасывается в cpsw_ndo_stop
+    if (unlikely(status < 0)) {
+        dev_kfree_skb_any(skb);
+        return;
+    }
+
+    // Запись об исходящем пакете: ровно один раз, даже если xmit возвращал NETDEV_TX_BUSY.
+    // После cpdma_chan_submit() пакет может быть уже освобожден, поэтому запись - здесь
+    cpsw_cap_packet(CPSW_CAP_TX, skb_get_queue_mapping(skb), skb);
+    dev_kfree_skb_any(skb);
+
+    b = this_cpu_ptr(&cpsw_tx_batch);
+    if (b->txq != txq) {
+        cpsw_tx_batch_flush(b);
+        b->txq = txq;
+    }
+    b->pkts++;
+    b->bytes += bytes;
+    ndev->stats.tx_packets++;
+    ndev->stats.tx_bytes += len;
+}
+
+// Обработка завершений передачи в NAPI: xmit распределяет пакеты по всем каналам,
+// поэтому обходятся все каналы с незавершенными дескрипторами (как cpsw_tx_mq_poll)
+static int cpsw_tx_poll(struct napi_struct *napi_tx, int budget) {
+    struct cpsw_common *cpsw = napi_to_cpsw(napi_tx);
+    int num_tx, cur_budget, ch;
+    u32 ch_map;
+
+    ch_map = cpdma_ctrl_txchs_state(cpsw->dma); // Каналы с ожидающими завершениями, старший бит - канал 0
+    for (ch = 0, num_tx = 0; ch_map & 0xff; ch_map <<= 1, ch++) {
+        if (!(ch_map & 0x80))
+            continue;
+
+        // Доля бюджета канала, но не больше остатка общего бюджета
+        cur_budget = min(cpsw->txv[ch].budget, budget - num_tx);
+        num_tx += cpdma_chan_process(cpsw->txv[ch].ch, cur_budget);
+        if (num_tx >= budget)
+            break;
+    }
+    cpsw_tx_batch_flush(this_cpu_ptr(&cpsw_tx_batch)); // Одно обновление BQL за вызов
+    if (num_tx < budget) {
+        napi_complete(napi_tx);
+        writel(0xff, &cpsw->wr_regs->tx_en);
+        if (cpsw->tx_irq_disabled) {
+            cpsw->tx_irq_disabled = false;
+            enable_irq(cpsw->irqs_table[1]);
+        }
+    }
+    return num_tx;
+}
+
 // Функция обработки передачи пакетов
 static netdev_tx_t cpsw_ndo_start_xmit(struct sk_buff *skb, struct net_device *ndev) {
-    skb_tx_timestamp(skb); // Устанавливаем временную метку для пакета
-
-    // Логируем информацию об области ввода-вывода перед передачей
-    printk(KERN_INFO "IO region: %lx, size: %d\n", ndev->base_addr, ndev->mem_end - ndev->base_addr);
+    struct cpsw_priv *priv = netdev_priv(ndev); // Получаем приватные данные устройства
+    struct cpsw_common *cpsw = priv->cpsw; // Получаем общие данные CPSW
+    int q_idx = skb_get_queue_mapping(skb) % cpsw->tx_ch_num; // Канал DMA очереди
+    struct cpdma_chan *txch = cpsw->txv[q_idx].ch;
+    struct netdev_queue *txq = netdev_get_tx_queue(ndev, q_idx);
+    unsigned int len = skb->len;
+    int ret;
 
-    // Логируем содержимое исходящего пакета и его размер
-    printk(KERN_INFO "Outgoing packet data: %p, size: %d\n", skb->data, skb->len);
+    // Завершение учитывается в той же очереди BQL, что и отправка
+    skb_set_queue_mapping(skb, q_idx);
+    skb_tx_timestamp(skb); // Устанавливаем временную метку для пакета
 
-    // Логика передачи пакета
-    ret = cpdma_chan_submit(txch, skb, skb->data, skb->len, priv->emac_port);
+    // Логика передачи пакета: дескриптор добавляется в цепочку канала. Регистр HDP
+    // записывается только при простое канала, поэтому пакеты пачки (netdev_xmit_more())
+    // подхватываются контроллером из цепочки без отдельного обращения к нему
+    ret = cpdma_chan_submit(txch, skb, skb->data, len, priv->emac_port);
     if (unlikely(ret != 0)) {
         cpsw_err(priv, tx_err, "desc submit failed\n"); // Логируем ошибку передачи
         goto fail; // Переходим к обработке ошибки
     }
 
+    // BQL: учет байт в очереди; при превышении лимита очередь останавливается до завершений
+    netdev_tx_sent_queue(txq, len);
+
+    // Нет свободных дескрипторов - останавливаем очередь до завершения передачи
+    if (unlikely(!cpdma_check_free_tx_desc(txch))) {
+        netif_tx_stop_queue(txq);
+        smp_mb__after_atomic(); // Остановка видна cpsw_tx_handler на других процессорах
+        if (cpdma_check_free_tx_desc(txch))
+            netif_tx_wake_queue(txq);
+    }
+
     return NETDEV_TX_OK; // Возвращаем статус успешной передачи
+
+fail:
+    ndev->stats.tx_dropped++;
+    netif_tx_stop_queue(txq);
+    smp_mb__after_atomic();
+    if (cpdma_check_free_tx_desc(txch))
+        netif_tx_wake_queue(txq);
+    return NETDEV_TX_BUSY;
 }
 
 // Функция инициализации драйвера
@@ -83,30 +198,55 @@ static int cpsw_probe(struct platform_device *pdev) {
     if (!cpsw)
         return -ENOMEM; // Возвращаем ошибку, если память не выделена
 
+    // Кольца захвата и файлы debugfs cpsw_capture/
+    int ret = cpsw_cap_init();
+    if (ret)
+        return ret;
+
     // Получаем номер прерывания для RX
     int irq = platform_get_irq_byname(pdev, "rx");
-    if (irq < 0)
-        return irq; // Возвращаем ошибку, если не удалось получить IRQ
+    if (irq < 0) {
+        ret = irq; // Не удалось получить IRQ
+        goto err_cap;
+    }
     cpsw->irqs_table[0] = irq; // Сохраняем номер IRQ для RX
 
     printk(KERN_INFO "IRQ rx number: %d\n", irq); // Логируем номер IRQ для RX
 
     // Получаем номер прерывания для TX
     irq = platform_get_irq_byname(pdev, "tx");
-    if (irq < 0)
-        return irq; // Возвращаем ошибку, если не удалось получить IRQ
+    if (irq < 0) {
+        ret = irq;
+        goto err_cap;
+    }
     cpsw->irqs_table[1] = irq; // Сохраняем номер IRQ для TX
 
     printk(KERN_INFO "IRQ tx number: %d\n", irq); // Логируем номер IRQ для TX
 
     // Получаем номер прерывания для других событий
     irq = platform_get_irq_byname(pdev, "misc");
-    if (irq <= 0)
-        return irq; // Возвращаем ошибку, если не удалось получить IRQ
+    if (irq <= 0) {
+        ret = irq ? irq : -ENXIO; // Нулевой номер - тоже ошибка, probe не должен вернуть 0
+        goto err_cap;
+    }
     cpsw->misc_irq = irq; // Сохраняем номер IRQ для других событий
 
     printk(KERN_INFO "IRQ misc number: %d\n", irq); // Логируем номер IRQ для других событий
 
     platform_set_drvdata(pdev, cpsw); // Сохраняем данные драйвера в платформенном устройстве
     return 0; // Возвращаем 0 для успешной инициализации
+
+err_cap:
+    cpsw_cap_exit(); // Удаляем кольца захвата и файлы debugfs
+    return ret;
+}
+
+// Функция удаления устройства
+static int cpsw_remove(struct platform_device *pdev) {
+    printk(KERN_INFO "cpsw_remove called"); // Логируем вызов функции удаления
+
+    // Устройства остановлены, записи в кольца завершены: файлы debugfs не должны
+    // пережить отвязку драйвера
+    cpsw_cap_exit();
+    return 0;
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include <linux/module.h> 
 #include <linux/kernel.h> 
 #include <linux/init.h>  
-#include <linux/timer.h>  
+#include <linux/hrtimer.h>  
 #include <linux/sched.h> 
 #include <linux/pid.h>   
 #include <linux/signal.h> 
@@ -9,104 +9,735 @@
 #include <linux/fs.h>     
 #include <linux/slab.h>  
 #include <linux/ktime.h> 
+#include <linux/math64.h>
+#include <linux/sched/task.h>
+#include <linux/mutex.h>
+#include <linux/cpu.h>
+#include <linux/cpuhotplug.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
+#include <linux/seqlock.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/eventfd.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/moduleparam.h>
+#include <linux/log2.h>
+
+#include "reaction_time_analyzer.h"
+
+#define CREATE_TRACE_POINTS
+#include "reaction_time_trace.h"
 
 
 MODULE_LICENSE("GPL"); // Лицензия
 MODULE_DESCRIPTION("A symbolic Linux driver to measure reaction time"); // Описание
 
 #define DEVICE_NAME "reaction_time_analyzer" // Имя устройства
-#define IOCTL_SET_FREQUENCY _IOW('a', 'b', unsigned long) // Команда для установки частоты
-#define IOCTL_GET_STATS _IOR('a', 'c', struct stats) // Команда для получения статистики
 
-#define MAX_REACTIONS 1000 // Максимальное количество реакций
-#define BINS 10 // Количество бинов для гистограммы
+// Лог-линейная гистограмма (в стиле HDR): значения меньше 2^HIST_SUB_BITS хранятся точно,
+// каждый следующий интервал [2^k, 2^(k+1)) делится на 2^(HIST_SUB_BITS-1) равных бинов,
+// поэтому относительная ошибка любого бина не превышает 2^-(HIST_SUB_BITS-1) (~1.6%)
+#define HIST_SUB_BITS 7  // Разрядность бина внутри степени двойки
+#define HIST_MAX_BITS 36 // Значения от 2^36 нс (~68 с) попадают в последний бин
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 2) << (HIST_SUB_BITS - 1)) // Количество бинов
+
+// Потоковая гистограмма времени реакции
+struct latency_hist {
+    u64 count;                 // Количество измерений
+    u64 sum;                   // Сумма измерений
+    u64 min;                   // Минимальное значение
+    u64 max;                   // Максимальное значение
+    u64 buckets[HIST_BUCKETS]; // Счетчики бинов
+};
 
-// Структура для хранения статистики
-struct stats {
-    unsigned long average_time; // Среднее время реакции
-    unsigned long max_time; // Максимальное время реакции
-    unsigned long histogram[BINS]; // Гистограмма времени реакции
+// Гистограмма с единственным писателем: читатели получают согласованный снимок без блокировок
+struct pcpu_hist {
+    seqcount_t seq;              // Согласованность снимка: гистограмма копируется целиком
+    bool reset_pending;          // Запрошен сброс, выполняется писателем при следующей записи
+    struct latency_hist h;       // Данные гистограммы
 };
 
-static struct timer_list reaction_timer; // Таймер для измерения времени реакции
-static unsigned long frequency = 1000; // Частота в миллисекундах
-static ktime_t last_signal_time; // Время последнего сигнала
-static unsigned long reaction_times[MAX_REACTIONS]; // Массив для хранения времен реакции
-static int reaction_count = 0; // Счетчик реакций
+// Состояние измерения на одном процессоре
+struct rta_cpu {
+    struct hrtimer timer;              // Закрепленный за процессором таймер воздействия
+    unsigned int cpu;                  // Номер процессора
+    struct task_struct __rcu *target;  // Зарегистрированный процесс-получатель воздействия
+    struct file *owner;                // Файл, через который зарегистрирован процесс
+    u32 notify;                        // Способ уведомления (RTA_NOTIFY_*)
+    struct eventfd_ctx __rcu *eventfd; // eventfd для RTA_NOTIFY_EVENTFD
+    wait_queue_head_t wait;            // Очередь ожидания для read()/poll()
+    atomic64_t seq;                    // Номер последнего срабатывания таймера (воздействия)
+    u64 read_seq;                      // Номер воздействия, полученного через read() (пишет только процесс)
+    seqcount_t stimulus_seq;           // Согласованность отметок последнего воздействия (пишет таймер)
+    atomic64_t last_signal_ns;         // Время последнего сигнала (0 - сигнала нет или он подтвержден)
+    u64 last_stimulus;                 // Номер последнего воздействия
+    s64 last_lateness_ns;              // Запаздывание таймера при последнем воздействии
+    struct rta_ring_ctrl *ring;        // Кольцо сырых измерений, отображаемое через mmap()
+    u32 ring_head;                     // Копия индекса записи (пишет только процесс)
+    struct pcpu_hist timer_hist ____cacheline_aligned;    // Пишет только обработчик таймера
+    struct pcpu_hist reaction_hist ____cacheline_aligned; // Пишет только зарегистрированный процесс
+};
+
+// Отметки одного воздействия, прочитанные одним снимком
+struct rta_stimulus {
+    u64 seq;         // Номер воздействия
+    s64 signal_ns;   // Время сигнала
+    s64 lateness_ns; // Запаздывание таймера
+};
+
+static const u32 percentile_ppm[RTA_PERCENTILES] = RTA_PERCENTILE_PPM; // Запрашиваемые перцентили
+
+static int major; // Основной номер устройства
+static enum cpuhp_state hp_state; // Динамическое состояние CPU hotplug
+static DEFINE_PER_CPU(struct rta_cpu *, rta_cpus); // Состояние измерения каждого процессора
+static u64 period_ns = 1000 * NSEC_PER_MSEC; // Период воздействия в наносекундах
+static clockid_t stimulus_clock = CLOCK_MONOTONIC; // Часы для отметок времени реакции
+static DEFINE_MUTEX(ctrl_lock); // Сериализация управляющих команд
+static size_t ring_map_size; // Размер области mmap() одного процессора
+
+static unsigned int ring_entries = 16384; // Емкость кольца сырых измерений каждого процессора
+module_param(ring_entries, uint, S_IRUGO);
+MODULE_PARM_DESC(ring_entries, "Емкость кольца сырых измерений процессора (степень двойки)");
+
+// Индекс бина для значения, O(1)
+static unsigned int hist_bucket(u64 value) {
+    unsigned int shift;
+
+    if (value >= (1ULL << HIST_MAX_BITS)) {
+        value = (1ULL << HIST_MAX_BITS) - 1; // Ограничение диапазона последним бином
+    }
+    if (value < (1ULL << HIST_SUB_BITS)) {
+        return value; // Малые значения хранятся точно
+    }
+    shift = fls64(value) - HIST_SUB_BITS; // Количество отбрасываемых младших битов
+    return (shift << (HIST_SUB_BITS - 1)) + (unsigned int)(value >> shift);
+}
+
+// Наибольшее значение, попадающее в бин
+static u64 hist_bucket_max(unsigned int index) {
+    unsigned int shift;
+    u64 sub;
+
+    if (index < (1U << HIST_SUB_BITS)) {
+        return index;
+    }
+    shift = (index >> (HIST_SUB_BITS - 1)) - 1;
+    sub = index - (shift << (HIST_SUB_BITS - 1));
+    return ((sub + 1) << shift) - 1;
+}
+
+// Добавление измерения в гистограмму, O(1)
+static void hist_record(struct latency_hist *h, u64 value) {
+    h->count++;
+    h->sum += value;
+    if (value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->buckets[hist_bucket(value)]++;
+}
+
+// Сброс гистограммы
+static void hist_reset(struct latency_hist *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = U64_MAX;
+}
+
+// Добавление одной гистограммы к другой
+static void hist_merge(struct latency_hist *dst, const struct latency_hist *src) {
+    unsigned int i;
 
-// Функция обратного вызова для таймера
-static void timer_callback(struct timer_list *t) {
-    struct pid *pid_struct;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    dst->min = min(dst->min, src->min);
+    dst->max = max(dst->max, src->max);
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+}
+
+// Заполнение статистики по гистограмме: точные min/max/среднее и перцентили с ошибкой бина
+static void hist_fill_stats(const struct latency_hist *h, struct stats *s) {
+    u64 seen = 0;
+    unsigned int i, p = 0;
+
+    s->version = RTA_STATS_VERSION;
+    s->size = sizeof(*s);
+    s->count = h->count;
+    if (!h->count) {
+        return; // Нет измерений - остальные поля нулевые
+    }
+    s->min_time = h->min;
+    s->max_time = h->max;
+    s->average_time = div64_u64(h->sum, h->count);
+
+    // Один проход по бинам: перцентили запрашиваются по возрастанию
+    for (i = 0; i < HIST_BUCKETS && p < RTA_PERCENTILES; i++) {
+        seen += h->buckets[i];
+        while (p < RTA_PERCENTILES &&
+               seen > mul_u64_u32_div(h->count, percentile_ppm[p], 1000000)) {
+            s->percentiles[p++] = clamp(hist_bucket_max(i), h->min, h->max);
+        }
+    }
+    while (p < RTA_PERCENTILES) {
+        s->percentiles[p++] = h->max; // Оставшиеся перцентили - максимум
+    }
+}
+
+// Запись измерения единственным писателем гистограммы, без блокировок
+static void pcpu_hist_record(struct pcpu_hist *ph, u64 value) {
+    preempt_disable(); // Читатель на том же процессоре не должен вытеснить незавершенную запись
+    write_seqcount_begin(&ph->seq);
+    if (READ_ONCE(ph->reset_pending)) {
+        hist_reset(&ph->h); // Отложенный сброс выполняет сам писатель
+        WRITE_ONCE(ph->reset_pending, false);
+    }
+    hist_record(&ph->h, value);
+    write_seqcount_end(&ph->seq);
+    preempt_enable();
+}
+
+// Согласованный снимок гистограммы: копия повторяется, если писатель изменил ее во время чтения
+static void pcpu_hist_snapshot(struct pcpu_hist *ph, struct latency_hist *out) {
+    unsigned int start;
+
+    do {
+        start = read_seqcount_begin(&ph->seq);
+        if (READ_ONCE(ph->reset_pending)) {
+            hist_reset(out); // Сброс запрошен - данные считаются пустыми
+        } else {
+            memcpy(out, &ph->h, sizeof(*out));
+        }
+    } while (read_seqcount_retry(&ph->seq, start));
+}
+
+// Текущее время по выбранным часам воздействия
+static ktime_t stimulus_now(void) {
+    return READ_ONCE(stimulus_clock) == CLOCK_MONOTONIC_RAW ? ktime_get_raw() : ktime_get();
+}
+
+// Функция обратного вызова для таймера, выполняется на закрепленном процессоре
+static enum hrtimer_restart timer_callback(struct hrtimer *t) {
+    struct rta_cpu *st = container_of(t, struct rta_cpu, timer);
+    ktime_t now = hrtimer_cb_get_time(t); // Время срабатывания по часам таймера
+    s64 lateness = ktime_to_ns(ktime_sub(now, hrtimer_get_expires(t)));
+    u64 seq = atomic64_inc_return(&st->seq); // Номер воздействия
     struct task_struct *task;
+    struct eventfd_ctx *ctx;
+    s64 signal_ns;
+
+    trace_rta_timer_fire(st->cpu, seq, ktime_to_ns(hrtimer_get_expires(t)), ktime_to_ns(now));
+
+    // Запаздывание самого таймера относительно запланированного срока
+    pcpu_hist_record(&st->timer_hist, lateness);
+
+    // Уведомление процесса, зарегистрированного на этом процессоре
+    rcu_read_lock();
+    task = rcu_dereference(st->target);
+    if (task) {
+        signal_ns = ktime_to_ns(stimulus_now()); // Отметка времени воздействия
+        // Номер, запаздывание и время сигнала публикуются вместе
+        write_seqcount_begin(&st->stimulus_seq);
+        st->last_stimulus = seq;
+        st->last_lateness_ns = lateness;
+        atomic64_set(&st->last_signal_ns, signal_ns);
+        write_seqcount_end(&st->stimulus_seq);
+        trace_rta_stimulus(st->cpu, seq, task->pid, READ_ONCE(st->notify), signal_ns);
+        switch (READ_ONCE(st->notify)) {
+            case RTA_NOTIFY_WAIT:
+                wake_up_interruptible(&st->wait); // Пробуждение read()/poll()
+                break;
+            case RTA_NOTIFY_EVENTFD:
+                ctx = rcu_dereference(st->eventfd);
+                if (ctx) {
+                    eventfd_signal(ctx, 1); // Пробуждение ожидающих eventfd
+                }
+                break;
+            default:
+                send_sig(SIGUSR1, task, 0); // Отправка сигнала SIGUSR1
+                break;
+        }
+    }
+    rcu_read_unlock();
 
-    // Отправка сигнала текущему процессу
-    pid_struct = find_get_pid(current->pid); // Получение структуры PID
-    if (pid_struct) {
-        task = pid_task(pid_struct, PIDTYPE_PID); // Получение структуры задачи по PID
-        if (task) {
-            send_sig(SIGUSR1, task, 0); // Отправка сигнала SIGUSR1
-            last_signal_time = ktime_get_real(); // Обновление времени последнего сигнала
+    // Перепланировка от абсолютного срока: опоздание одного срабатывания не сдвигает следующие,
+    // пропущенные периоды отбрасываются целиком
+    hrtimer_forward(t, now, ns_to_ktime(READ_ONCE(period_ns)));
+    return HRTIMER_RESTART;
+}
+
+// Запуск таймера текущего процессора, первый срок - через один период
+static void start_local_timer(void *unused) {
+    struct rta_cpu *st = this_cpu_read(rta_cpus);
+
+    hrtimer_start(&st->timer, ktime_add_ns(ktime_get(), READ_ONCE(period_ns)), HRTIMER_MODE_ABS_PINNED);
+}
+
+// Процессор включен: запуск его таймера (выполняется на самом процессоре)
+static int rta_cpu_online(unsigned int cpu) {
+    start_local_timer(NULL);
+    return 0;
+}
+
+// Процессор выключается: остановка его таймера
+static int rta_cpu_offline(unsigned int cpu) {
+    hrtimer_cancel(&per_cpu(rta_cpus, cpu)->timer);
+    return 0;
+}
+
+// Перезапуск таймеров всех включенных процессоров с текущими параметрами
+static void restart_timers(void) {
+    unsigned int cpu;
+
+    cpus_read_lock(); // Исключение одновременного CPU hotplug
+    for_each_online_cpu(cpu) {
+        struct rta_cpu *st = per_cpu(rta_cpus, cpu);
+
+        hrtimer_cancel(&st->timer); // Ожидание завершения выполняющегося обработчика
+        atomic64_set(&st->last_signal_ns, 0); // Отметки по старым часам недействительны
+    }
+    on_each_cpu(start_local_timer, NULL, 1); // Закрепленный таймер запускается на своем процессоре
+    cpus_read_unlock();
+}
+
+// Снятие регистрации процесса с процессора; вызывается под ctrl_lock
+static void unregister_target(struct rta_cpu *st) {
+    struct task_struct *task = rcu_dereference_protected(st->target, lockdep_is_held(&ctrl_lock));
+    struct eventfd_ctx *ctx = rcu_dereference_protected(st->eventfd, lockdep_is_held(&ctrl_lock));
+
+    if (!task) {
+        return;
+    }
+    RCU_INIT_POINTER(st->target, NULL);
+    RCU_INIT_POINTER(st->eventfd, NULL);
+    st->owner = NULL;
+    WRITE_ONCE(st->notify, RTA_NOTIFY_SIGNAL);
+    // Обработчик таймера больше не использует задачу и eventfd, а процесс завершил
+    // measure_reaction_time(): у гистограммы реакции и кольца снова не больше одного писателя
+    synchronize_rcu();
+    wake_up_interruptible_all(&st->wait); // Ожидающий read() завершится с ошибкой
+    if (ctx) {
+        eventfd_ctx_put(ctx);
+    }
+    put_task_struct(task);
+}
+
+// Выбор способа уведомления для процессора, на котором зарегистрирован вызывающий процесс
+static long set_notify(const struct rta_notify *n) {
+    struct eventfd_ctx *ctx = NULL, *old;
+    struct rta_cpu *st;
+
+    if (n->cpu >= nr_cpu_ids || !cpu_possible(n->cpu) || n->mode > RTA_NOTIFY_EVENTFD) {
+        return -EINVAL;
+    }
+    if (n->mode == RTA_NOTIFY_EVENTFD) {
+        ctx = eventfd_ctx_fdget(n->eventfd); // Ссылка на eventfd вызывающего процесса
+        if (IS_ERR(ctx)) {
+            return PTR_ERR(ctx);
+        }
+    }
+    st = per_cpu(rta_cpus, n->cpu);
+    mutex_lock(&ctrl_lock);
+    if (rcu_access_pointer(st->target) != current) {
+        mutex_unlock(&ctrl_lock);
+        if (ctx) {
+            eventfd_ctx_put(ctx);
+        }
+        return -EPERM; // Способ уведомления выбирает сам зарегистрированный процесс
+    }
+    old = rcu_dereference_protected(st->eventfd, lockdep_is_held(&ctrl_lock));
+    rcu_assign_pointer(st->eventfd, ctx);
+    WRITE_ONCE(st->notify, n->mode);
+    mutex_unlock(&ctrl_lock);
+    if (old) {
+        synchronize_rcu(); // Обработчик таймера больше не использует старый eventfd
+        eventfd_ctx_put(old);
+    }
+    return 0;
+}
+
+// Регистрация вызывающего процесса получателем воздействия на процессоре cpu
+static long register_target(struct file *file, __u32 cpu) {
+    struct rta_cpu *st;
+    long ret;
+
+    if (cpu >= nr_cpu_ids || !cpu_possible(cpu)) {
+        return -EINVAL;
+    }
+    // Процесс закрепляется на процессоре, как измерительные потоки cyclictest
+    ret = set_cpus_allowed_ptr(current, cpumask_of(cpu));
+    if (ret) {
+        return ret;
+    }
+    st = per_cpu(rta_cpus, cpu);
+    mutex_lock(&ctrl_lock);
+    cpus_read_lock(); // Исключение одновременного CPU hotplug
+    hrtimer_cancel(&st->timer); // Смена получателя без выполняющегося обработчика таймера
+    unregister_target(st); // Прежний процесс завершил запись в гистограмму и кольцо
+    atomic64_set(&st->last_signal_ns, 0);
+    st->read_seq = atomic64_read(&st->seq); // Воздействия до регистрации не читаются
+    get_task_struct(current);
+    st->owner = file;
+    rcu_assign_pointer(st->target, current);
+    if (cpu_online(cpu)) {
+        smp_call_function_single(cpu, start_local_timer, NULL, 1);
+    }
+    cpus_read_unlock();
+    mutex_unlock(&ctrl_lock);
+    return 0;
+}
+
+// Состояние процессора, на котором зарегистрирован вызывающий процесс
+static struct rta_cpu *current_target_cpu(void) {
+    struct rta_cpu *st = per_cpu(rta_cpus, raw_smp_processor_id());
+    unsigned int cpu;
+
+    // Быстрый путь: процесс закреплен и выполняется на своем процессоре
+    if (rcu_access_pointer(st->target) == current) {
+        return st;
+    }
+    for_each_possible_cpu(cpu) {
+        st = per_cpu(rta_cpus, cpu);
+        if (rcu_access_pointer(st->target) == current) {
+            return st;
         }
-        put_pid(pid_struct); // Освобождение структуры PID
     }
+    return NULL;
+}
+
+// Запись сырого измерения в кольцо процессора: единственный писатель - зарегистрированный процесс,
+// читатель - пользовательская программа через mmap(); при заполнении измерение отбрасывается
+static void ring_push(struct rta_cpu *st, const struct rta_stimulus *stim, u64 ack_ns) {
+    struct rta_ring_ctrl *ring = st->ring;
+    struct rta_sample *sample;
+    u32 head = st->ring_head;
 
-    // Перепланировка таймера
-    mod_timer(&reaction_timer, jiffies + msecs_to_jiffies(frequency));
+    if (head - smp_load_acquire(&ring->tail) >= ring_entries) {
+        WRITE_ONCE(ring->dropped, ring->dropped + 1); // Кольцо заполнено
+        return;
+    }
+    sample = (struct rta_sample *)((char *)ring + PAGE_SIZE) + (head & (ring_entries - 1));
+    sample->seq = stim->seq;
+    sample->stimulus_ns = stim->signal_ns;
+    sample->ack_ns = ack_ns;
+    sample->timer_lateness_ns = stim->lateness_ns;
+    sample->cpu = st->cpu;
+    sample->notify = READ_ONCE(st->notify);
+    st->ring_head = head + 1;
+    smp_store_release(&ring->head, head + 1); // Публикация записи читателю
+}
+
+// Подтверждение последнего воздействия: номер, время сигнала и запаздывание берутся из одного
+// снимка, а сигнал снимается, только если таймер еще не опубликовал следующее воздействие
+static bool stimulus_claim(struct rta_cpu *st, struct rta_stimulus *out) {
+    unsigned int start;
+
+    do {
+        do {
+            start = read_seqcount_begin(&st->stimulus_seq);
+            out->seq = st->last_stimulus;
+            out->lateness_ns = st->last_lateness_ns;
+            out->signal_ns = atomic64_read(&st->last_signal_ns);
+        } while (read_seqcount_retry(&st->stimulus_seq, start));
+        if (!out->signal_ns) {
+            return false; // Нет неподтвержденного воздействия
+        }
+    } while (atomic64_cmpxchg(&st->last_signal_ns, out->signal_ns, 0) != out->signal_ns);
+    return true;
 }
 
 // Функция для измерения времени реакции
-static void measure_reaction_time(void) {
-    ktime_t end_time = ktime_get_real(); // Получение текущего времени
-    unsigned long reaction_time = ktime_to_ns(ktime_sub(end_time, last_signal_time)); // Вычисление времени реакции
+static long measure_reaction_time(void) {
+    ktime_t end_time = stimulus_now(); // Получение текущего времени
+    struct rta_cpu *st = current_target_cpu();
+    struct rta_stimulus stim;
 
-    // Сохранение времени реакции, если не превышен лимит
-    if (reaction_count < MAX_REACTIONS) {
-        reaction_times[reaction_count++] = reaction_time; // Сохранение времени реакции в массив
+    if (!st) {
+        return -EPERM; // Вызывающий процесс не зарегистрирован
+    }
+    // Запись выполняется только зарегистрированным процессом; снятие регистрации ждет ее
+    // завершения в synchronize_rcu()
+    rcu_read_lock();
+    if (rcu_access_pointer(st->target) != current) {
+        rcu_read_unlock();
+        return -EPERM; // Регистрация снята
     }
+    // Каждое воздействие подтверждается один раз
+    if (!stimulus_claim(st, &stim) || ktime_to_ns(end_time) < stim.signal_ns) {
+        rcu_read_unlock();
+        return -EAGAIN; // Нет неподтвержденного воздействия
+    }
+    // Обновление гистограммы процессора за O(1), без ограничения на количество измерений
+    pcpu_hist_record(&st->reaction_hist, ktime_to_ns(end_time) - stim.signal_ns);
+    ring_push(st, &stim, ktime_to_ns(end_time));
+    rcu_read_unlock();
+    trace_rta_reaction(st->cpu, stim.seq, stim.signal_ns, ktime_to_ns(end_time));
+    return 0;
+}
+
+// Блокирующее ожидание воздействия: возвращает номер последнего воздействия (__u64)
+static ssize_t device_read(struct file *file, char __user *buffer, size_t len, loff_t *offset) {
+    struct rta_cpu *st = current_target_cpu();
+    u64 seq;
+    int ret;
+
+    if (!st) {
+        return -EPERM; // Вызывающий процесс не зарегистрирован
+    }
+    if (len < sizeof(seq)) {
+        return -EINVAL;
+    }
+    if (atomic64_read(&st->seq) == st->read_seq) {
+        if (file->f_flags & O_NONBLOCK) {
+            return -EAGAIN;
+        }
+        ret = wait_event_interruptible(st->wait, atomic64_read(&st->seq) != st->read_seq ||
+                                       rcu_access_pointer(st->target) != current);
+        if (ret) {
+            return ret;
+        }
+        if (rcu_access_pointer(st->target) != current) {
+            return -EPERM; // Регистрация снята во время ожидания
+        }
+    }
+    seq = atomic64_read(&st->seq);
+    st->read_seq = seq;
+    if (copy_to_user(buffer, &seq, sizeof(seq))) {
+        return -EFAULT;
+    }
+    return sizeof(seq);
+}
+
+// Подтверждение реакции записью: время фиксируется при входе в вызов
+static ssize_t device_write(struct file *file, const char __user *buffer, size_t len, loff_t *offset) {
+    long ret = measure_reaction_time();
+
+    return ret ? ret : len;
+}
+
+// Готовность к чтению (poll/epoll): есть непрочитанное воздействие
+static __poll_t device_poll(struct file *file, poll_table *wait) {
+    struct rta_cpu *st = current_target_cpu();
+    __poll_t mask = EPOLLOUT | EPOLLWRNORM; // Подтверждение реакции возможно всегда
+
+    if (!st) {
+        return EPOLLERR;
+    }
+    poll_wait(file, &st->wait, wait);
+    if (atomic64_read(&st->seq) != st->read_seq) {
+        mask |= EPOLLIN | EPOLLRDNORM;
+    }
+    return mask;
+}
+
+// Отображение кольца процессора: смещение mmap() равно cpu * map_size из IOCTL_GET_RING_INFO
+static int device_mmap(struct file *file, struct vm_area_struct *vma) {
+    unsigned long ring_pages = ring_map_size >> PAGE_SHIFT;
+    unsigned long cpu = vma->vm_pgoff / ring_pages;
+
+    if (vma->vm_pgoff % ring_pages || cpu >= nr_cpu_ids || !cpu_possible(cpu)) {
+        return -EINVAL;
+    }
+    if (vma->vm_end - vma->vm_start > ring_map_size) {
+        return -EINVAL;
+    }
+    return remap_vmalloc_range(vma, per_cpu(rta_cpus, cpu)->ring, 0);
+}
+
+// Копирование статистики гистограммы в пользовательское пространство
+static long copy_hist_stats(const struct latency_hist *h, struct stats __user *arg) {
+    struct stats s = {0}; // Инициализация структуры статистики
+
+    hist_fill_stats(h, &s);
+    // Копирование статистики в пользовательское пространство
+    if (copy_to_user(arg, &s, sizeof(struct stats))) {
+        return -EFAULT; // Ошибка при копировании данных в пользовательское пространство
+    }
+    return 0;
+}
+
+// Объединенная по всем процессорам статистика (timer - запаздывание таймера, иначе реакция)
+static long get_merged_stats(bool timer, struct stats __user *arg) {
+    struct latency_hist *merged, *snap;
+    unsigned int cpu;
+    long ret;
+
+    merged = kmalloc(sizeof(*merged), GFP_KERNEL);
+    snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+    if (!merged || !snap) {
+        kfree(merged);
+        kfree(snap);
+        return -ENOMEM;
+    }
+    hist_reset(merged);
+    for_each_possible_cpu(cpu) {
+        struct rta_cpu *st = per_cpu(rta_cpus, cpu);
+
+        pcpu_hist_snapshot(timer ? &st->timer_hist : &st->reaction_hist, snap);
+        hist_merge(merged, snap);
+    }
+    ret = copy_hist_stats(merged, arg);
+    kfree(snap);
+    kfree(merged);
+    return ret;
+}
+
+// Статистика одного процессора
+static long get_cpu_stats(struct cpu_stats __user *arg) {
+    struct latency_hist *snap;
+    struct rta_cpu *st;
+    __u32 cpu;
+    long ret;
+
+    if (get_user(cpu, &arg->cpu)) {
+        return -EFAULT;
+    }
+    if (cpu >= nr_cpu_ids || !cpu_possible(cpu)) {
+        return -EINVAL;
+    }
+    snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+    if (!snap) {
+        return -ENOMEM;
+    }
+    st = per_cpu(rta_cpus, cpu);
+    pcpu_hist_snapshot(&st->reaction_hist, snap);
+    ret = copy_hist_stats(snap, &arg->reaction);
+    if (!ret) {
+        pcpu_hist_snapshot(&st->timer_hist, snap);
+        ret = copy_hist_stats(snap, &arg->timer);
+    }
+    if (!ret && (put_user(cpu_online(cpu) ? 1 : 0, &arg->online) ||
+                 put_user(READ_ONCE(st->notify), &arg->notify))) {
+        ret = -EFAULT;
+    }
+    kfree(snap);
+    return ret;
 }
 
 // Обработчик IOCTL для управления устройством
 static long device_ioctl(struct file *file, unsigned int cmd, unsigned long arg) {
     switch (cmd) {
-        case IOCTL_SET_FREQUENCY:
+        case IOCTL_SET_FREQUENCY: {
+            unsigned long frequency; // Период в миллисекундах (устаревший интерфейс)
+
             // Установка частоты
             if (copy_from_user(&frequency, (unsigned long *)arg, sizeof(unsigned long))) {
                 return -EFAULT; // Ошибка при копировании данных из пользовательского пространства
             }
-            mod_timer(&reaction_timer, jiffies + msecs_to_jiffies(frequency)); // Перепланировка таймера
+            if (frequency > div_u64(RTA_MAX_PERIOD_NS, NSEC_PER_MSEC) ||
+                (u64)frequency * NSEC_PER_MSEC < RTA_MIN_PERIOD_NS) {
+                return -EINVAL; // Период вне допустимого диапазона
+            }
+            mutex_lock(&ctrl_lock);
+            WRITE_ONCE(period_ns, (u64)frequency * NSEC_PER_MSEC);
+            restart_timers(); // Перепланировка таймеров
+            mutex_unlock(&ctrl_lock);
             break;
-        case IOCTL_GET_STATS: {
-            struct stats s = {0}; // Инициализация структуры статистики
-            unsigned long total_time = 0; // Переменная для хранения общего времени
-            unsigned long max_time = 0; // Переменная для хранения максимального времени
-            unsigned long bin_size = 0; // Размер бина для гистограммы
-            int i;
-
-            // Вычисление общего времени и максимального времени
-            for (i = 0; i < reaction_count; i++) {
-                total_time += reaction_times[i];
-                if (reaction_times[i] > max_time) {
-                    max_time = reaction_times[i]; // Обновление максимального времени
-                }
+        }
+        case IOCTL_SET_PERIOD_NS: {
+            __u64 period;
+
+            // Установка периода в наносекундах
+            if (copy_from_user(&period, (__u64 *)arg, sizeof(period))) {
+                return -EFAULT;
+            }
+            if (period < RTA_MIN_PERIOD_NS || period > RTA_MAX_PERIOD_NS) {
+                return -EINVAL; // Период вне допустимого диапазона
             }
+            mutex_lock(&ctrl_lock);
+            WRITE_ONCE(period_ns, period);
+            restart_timers(); // Перепланировка таймеров
+            mutex_unlock(&ctrl_lock);
+            break;
+        }
+        case IOCTL_SET_CLOCK: {
+            __u32 clock;
 
-            // Вычисление среднего времени
-            s.average_time = reaction_count ? total_time / reaction_count : 0;
-            s.max_time = max_time;
+            // Выбор часов для отметок времени реакции
+            if (copy_from_user(&clock, (__u32 *)arg, sizeof(clock))) {
+                return -EFAULT;
+            }
+            if (clock != CLOCK_MONOTONIC && clock != CLOCK_MONOTONIC_RAW) {
+                return -EINVAL; // Поддерживаются только монотонные часы
+            }
+            mutex_lock(&ctrl_lock);
+            WRITE_ONCE(stimulus_clock, clock);
+            restart_timers(); // Отметки по старым часам сбрасываются
+            mutex_unlock(&ctrl_lock);
+            break;
+        }
+        case IOCTL_REGISTER_TARGET: {
+            __u32 cpu;
 
-            // Построение гистограммы
-            bin_size = max_time / BINS; // Определение размера бина
-            for (i = 0; i < reaction_count; i++) {
-                int bin_index = reaction_times[i] / bin_size; // Определение индекса бина
-                if (bin_index >= BINS) {
-                    bin_index = BINS - 1; // Последний бин для переполнения
-                }
-                s.histogram[bin_index]++; // Увеличение счетчика в соответствующем бине
+            // Регистрация вызывающего процесса на процессоре
+            if (copy_from_user(&cpu, (__u32 *)arg, sizeof(cpu))) {
+                return -EFAULT;
+            }
+            return register_target(file, cpu);
+        }
+        case IOCTL_UNREGISTER_TARGET: {
+            struct rta_cpu *st;
+            __u32 cpu;
+
+            if (copy_from_user(&cpu, (__u32 *)arg, sizeof(cpu))) {
+                return -EFAULT;
+            }
+            if (cpu >= nr_cpu_ids || !cpu_possible(cpu)) {
+                return -EINVAL;
+            }
+            st = per_cpu(rta_cpus, cpu);
+            mutex_lock(&ctrl_lock);
+            if (rcu_access_pointer(st->target) != current) {
+                mutex_unlock(&ctrl_lock);
+                return -EPERM; // Регистрацию снимает только сам зарегистрированный процесс
+            }
+            unregister_target(st);
+            mutex_unlock(&ctrl_lock);
+            break;
+        }
+        case IOCTL_SET_NOTIFY: {
+            struct rta_notify n;
+
+            // Выбор способа уведомления: сигнал, read()/poll() или eventfd
+            if (copy_from_user(&n, (struct rta_notify *)arg, sizeof(n))) {
+                return -EFAULT;
+            }
+            return set_notify(&n);
+        }
+        case IOCTL_GET_RING_INFO: {
+            struct rta_ring_info info = {
+                .entries = ring_entries,
+                .sample_size = sizeof(struct rta_sample),
+                .data_offset = PAGE_SIZE,
+                .map_size = ring_map_size,
+            };
+
+            if (copy_to_user((struct rta_ring_info *)arg, &info, sizeof(info))) {
+                return -EFAULT;
             }
+            break;
+        }
+        case IOCTL_REACT:
+            return measure_reaction_time(); // Подтверждение реакции на воздействие
+        case IOCTL_GET_STATS:
+            return get_merged_stats(false, (struct stats __user *)arg); // Статистика времени реакции
+        case IOCTL_GET_TIMER_STATS:
+            return get_merged_stats(true, (struct stats __user *)arg); // Статистика запаздывания таймера
+        case IOCTL_GET_CPU_STATS:
+            return get_cpu_stats((struct cpu_stats __user *)arg); // Статистика одного процессора
+        case IOCTL_RESET_STATS: {
+            unsigned int cpu;
 
-            // Копирование статистики в пользовательское пространство
-            if (copy_to_user((struct stats *)arg, &s, sizeof(struct stats))) {
-                return -EFAULT; // Ошибка при копировании данных в пользовательское пространство
+            // Сброс выполняют сами писатели при следующей записи, читатели сразу видят пустые данные
+            for_each_possible_cpu(cpu) {
+                struct rta_cpu *st = per_cpu(rta_cpus, cpu);
+
+                WRITE_ONCE(st->timer_hist.reset_pending, true);
+                WRITE_ONCE(st->reaction_hist.reset_pending, true);
             }
             break;
         }
@@ -116,25 +747,112 @@ static long device_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     return 0; // Успешное выполнение
 }
 
+// Закрытие устройства: снятие регистраций, сделанных через этот файл
+static int device_release(struct inode *inode, struct file *file) {
+    unsigned int cpu;
+
+    mutex_lock(&ctrl_lock);
+    for_each_possible_cpu(cpu) {
+        struct rta_cpu *st = per_cpu(rta_cpus, cpu);
+
+        if (st->owner == file) {
+            unregister_target(st);
+        }
+    }
+    mutex_unlock(&ctrl_lock);
+    return 0;
+}
+
 // Определение операций с файлом
 static struct file_operations fops = {
+    .owner = THIS_MODULE,
     .unlocked_ioctl = device_ioctl, // Указатель на обработчик IOCTL
+    .read = device_read,            // Ожидание воздействия
+    .write = device_write,          // Подтверждение реакции
+    .poll = device_poll,            // Готовность для poll/epoll
+    .mmap = device_mmap,            // Кольца сырых измерений
+    .release = device_release,      // Снятие регистраций при закрытии
 };
 
+// Освобождение состояний процессоров
+static void free_cpu_states(void) {
+    unsigned int cpu;
+
+    for_each_possible_cpu(cpu) {
+        if (per_cpu(rta_cpus, cpu)) {
+            vfree(per_cpu(rta_cpus, cpu)->ring);
+        }
+        kfree(per_cpu(rta_cpus, cpu));
+        per_cpu(rta_cpus, cpu) = NULL;
+    }
+}
+
+// Выделение состояний всех возможных процессоров в памяти их NUMA-узлов
+static int alloc_cpu_states(void) {
+    unsigned int cpu;
+
+    if (!is_power_of_2(ring_entries)) {
+        pr_alert("ring_entries must be a power of two\n");
+        return -EINVAL;
+    }
+    // Управляющая страница и данные кольца
+    ring_map_size = PAGE_SIZE + PAGE_ALIGN((size_t)ring_entries * sizeof(struct rta_sample));
+
+    for_each_possible_cpu(cpu) {
+        struct rta_cpu *st = kzalloc_node(sizeof(*st), GFP_KERNEL, cpu_to_node(cpu));
+
+        if (!st) {
+            free_cpu_states();
+            return -ENOMEM;
+        }
+        per_cpu(rta_cpus, cpu) = st;
+        st->ring = vmalloc_user(ring_map_size); // Обнуленная память, пригодная для mmap()
+        if (!st->ring) {
+            free_cpu_states();
+            return -ENOMEM;
+        }
+        st->ring->entries = ring_entries;
+        st->ring->sample_size = sizeof(struct rta_sample);
+        st->cpu = cpu;
+        hrtimer_init(&st->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_PINNED);
+        st->timer.function = timer_callback;
+        init_waitqueue_head(&st->wait);
+        seqcount_init(&st->stimulus_seq);
+        seqcount_init(&st->timer_hist.seq);
+        seqcount_init(&st->reaction_hist.seq);
+        hist_reset(&st->timer_hist.h);
+        hist_reset(&st->reaction_hist.h);
+    }
+    return 0;
+}
+
 // Функция инициализации драйвера
 static int __init reaction_time_driver_init(void) {
     int ret;
 
+    ret = alloc_cpu_states();
+    if (ret) {
+        return ret;
+    }
+
     // Регистрация символьного устройства
-    ret = register_chrdev(0, DEVICE_NAME, &fops);
-    if (ret < 0) {
+    major = register_chrdev(0, DEVICE_NAME, &fops);
+    if (major < 0) {
         pr_alert("Failed to register character device\n"); // Ошибка регистрации устройства
-        return ret;
+        free_cpu_states();
+        return major;
     }
 
-    // Настройка таймера
-    timer_setup(&reaction_timer, timer_callback, 0);
-    mod_timer(&reaction_timer, jiffies + msecs_to_jiffies(frequency)); // Запуск таймера
+    // Запуск закрепленных таймеров на всех включенных процессорах с поддержкой CPU hotplug
+    ret = cpuhp_setup_state(CPUHP_AP_ONLINE_DYN, "reaction_time_analyzer:online",
+                            rta_cpu_online, rta_cpu_offline);
+    if (ret < 0) {
+        pr_alert("Failed to set up CPU hotplug state\n");
+        unregister_chrdev(major, DEVICE_NAME);
+        free_cpu_states();
+        return ret;
+    }
+    hp_state = ret;
 
     pr_info("Reaction time driver initialized\n"); // Сообщение об успешной инициализации
     return 0;
@@ -142,12 +860,19 @@ static int __init reaction_time_driver_init(void) {
 
 // Функция выгрузки драйвера
 static void __exit reaction_time_driver_exit(void) {
-    del_timer(&reaction_timer); // Удаление таймера
-    unregister_chrdev(0, DEVICE_NAME); // Удаление символьного устройства
+    unsigned int cpu;
+
+    cpuhp_remove_state(hp_state); // Остановка таймеров всех процессоров
+    unregister_chrdev(major, DEVICE_NAME); // Удаление символьного устройства
+    mutex_lock(&ctrl_lock);
+    for_each_possible_cpu(cpu) {
+        unregister_target(per_cpu(rta_cpus, cpu));
+    }
+    mutex_unlock(&ctrl_lock);
+    free_cpu_states();
     pr_info("Reaction time driver exited\n"); // Сообщение о выгрузке драйвера
 }
 
 // Определение функций и лицензии модуля
 module_init(reaction_time_driver_init);
 module_exit(reaction_time_driver_exit);
-
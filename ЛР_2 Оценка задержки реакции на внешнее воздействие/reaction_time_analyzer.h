@@ -0,0 +1,96 @@
+#ifndef REACTION_TIME_ANALYZER_H
+#define REACTION_TIME_ANALYZER_H
+
+// Общий для модуля и пользовательских программ интерфейс устройства reaction_time_analyzer
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define RTA_STATS_VERSION 2 // Версия структуры статистики
+#define RTA_PERCENTILES 5   // Количество перцентилей в статистике
+
+// Перцентили в миллионных долях: p50, p90, p99, p99.9, p99.99
+#define RTA_PERCENTILE_PPM { 500000, 900000, 990000, 999000, 999900 }
+
+// Структура статистики времени реакции (все времена в наносекундах)
+struct stats {
+    __u32 version;                      // Версия структуры (RTA_STATS_VERSION)
+    __u32 size;                         // Размер структуры в байтах
+    __u64 count;                        // Количество измерений
+    __u64 min_time;                     // Минимальное время реакции
+    __u64 max_time;                     // Максимальное время реакции
+    __u64 average_time;                 // Среднее время реакции
+    __u64 percentiles[RTA_PERCENTILES]; // Перцентили времени реакции (RTA_PERCENTILE_PPM)
+};
+
+// Статистика одного процессора
+struct cpu_stats {
+    __u32 cpu;             // Номер процессора (задается вызывающим)
+    __u32 online;          // Процессор включен
+    struct stats reaction; // Время реакции зарегистрированного процесса
+    struct stats timer;    // Запаздывание таймера процессора
+    __u32 notify;          // Способ уведомления (RTA_NOTIFY_*)
+    __u32 reserved;
+};
+
+// Способы уведомления процесса о воздействии
+#define RTA_NOTIFY_SIGNAL 0  // Сигнал SIGUSR1 (по умолчанию)
+#define RTA_NOTIFY_WAIT 1    // Пробуждение блокирующего read() и poll()/epoll
+#define RTA_NOTIFY_EVENTFD 2 // Сигнал eventfd, зарегистрированного процессом
+
+// Параметры IOCTL_SET_NOTIFY
+struct rta_notify {
+    __u32 cpu;     // Процессор, на котором зарегистрирован вызывающий процесс
+    __u32 mode;    // Способ уведомления (RTA_NOTIFY_*)
+    __s32 eventfd; // Дескриптор eventfd для RTA_NOTIFY_EVENTFD
+    __u32 reserved;
+};
+
+// Сырое измерение в кольце mmap() (все времена в наносекундах)
+struct rta_sample {
+    __u64 seq;               // Номер воздействия
+    __u64 stimulus_ns;       // Время воздействия
+    __u64 ack_ns;            // Время подтверждения реакции
+    __u64 timer_lateness_ns; // Запаздывание таймера при воздействии
+    __u32 cpu;               // Процессор
+    __u32 notify;            // Способ уведомления (RTA_NOTIFY_*)
+};
+
+#define RTA_RING_ALIGN 128 // Индексы записи и чтения находятся в разных кэш-линиях
+
+// Управляющая страница кольца (начало области mmap() процессора); данные - с data_offset
+struct rta_ring_ctrl {
+    __u32 head;                             // Индекс записи (пишет модуль, release)
+    __u8 pad0[RTA_RING_ALIGN - sizeof(__u32)];
+    __u32 tail;                             // Индекс чтения (пишет читатель, release)
+    __u8 pad1[RTA_RING_ALIGN - sizeof(__u32)];
+    __u64 dropped;                          // Количество отброшенных при заполнении измерений
+    __u32 entries;                          // Емкость кольца (степень двойки)
+    __u32 sample_size;                      // Размер struct rta_sample
+};
+
+// Параметры колец для mmap()
+struct rta_ring_info {
+    __u32 entries;     // Емкость кольца (степень двойки)
+    __u32 sample_size; // Размер struct rta_sample
+    __u64 data_offset; // Смещение данных от начала области процессора
+    __u64 map_size;    // Размер области процессора; смещение mmap() для процессора cpu - cpu * map_size
+};
+
+#define RTA_MIN_PERIOD_NS 10000ULL        // Минимальный период воздействия (10 мкс)
+#define RTA_MAX_PERIOD_NS 3600000000000ULL // Максимальный период воздействия (1 час)
+
+#define IOCTL_SET_FREQUENCY _IOW('a', 'b', unsigned long) // Команда для установки периода в миллисекундах
+#define IOCTL_GET_STATS _IOR('a', 'c', struct stats)     // Команда для получения статистики времени реакции
+#define IOCTL_RESET_STATS _IO('a', 'd')                   // Команда для сброса статистики
+#define IOCTL_SET_PERIOD_NS _IOW('a', 'e', __u64)         // Команда для установки периода в наносекундах
+#define IOCTL_SET_CLOCK _IOW('a', 'f', __u32)             // Выбор часов: CLOCK_MONOTONIC или CLOCK_MONOTONIC_RAW
+#define IOCTL_GET_TIMER_STATS _IOR('a', 'g', struct stats) // Команда для получения статистики запаздывания таймера
+#define IOCTL_REGISTER_TARGET _IOW('a', 'h', __u32)       // Регистрация вызывающего процесса на процессоре
+#define IOCTL_UNREGISTER_TARGET _IOW('a', 'i', __u32)     // Снятие регистрации с процессора
+#define IOCTL_REACT _IO('a', 'j')                         // Подтверждение реакции на воздействие
+#define IOCTL_GET_CPU_STATS _IOWR('a', 'k', struct cpu_stats) // Статистика одного процессора
+#define IOCTL_SET_NOTIFY _IOW('a', 'l', struct rta_notify) // Выбор способа уведомления
+#define IOCTL_GET_RING_INFO _IOR('a', 'm', struct rta_ring_info) // Параметры колец сырых измерений
+
+#endif // REACTION_TIME_ANALYZER_H
@@ -0,0 +1,101 @@
+// Точки трассировки модуля reaction_time_analyzer для perf/trace-cmd/ftrace.
+// При отключенных событиях каждая точка - это nop на статическом ключе.
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM reaction_time
+
+#if !defined(_REACTION_TIME_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _REACTION_TIME_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// Срабатывание закрепленного таймера процессора
+TRACE_EVENT(rta_timer_fire,
+
+    TP_PROTO(unsigned int cpu, u64 seq, s64 expires_ns, s64 now_ns),
+
+    TP_ARGS(cpu, seq, expires_ns, now_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, cpu)
+        __field(u64, seq)
+        __field(s64, expires_ns)
+        __field(s64, now_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu = cpu;
+        __entry->seq = seq;
+        __entry->expires_ns = expires_ns;
+        __entry->now_ns = now_ns;
+    ),
+
+    TP_printk("cpu=%u seq=%llu expires=%lld now=%lld lateness=%lld",
+              __entry->cpu, __entry->seq, __entry->expires_ns, __entry->now_ns,
+              __entry->now_ns - __entry->expires_ns)
+);
+
+// Воздействие доставлено зарегистрированному процессу
+TRACE_EVENT(rta_stimulus,
+
+    TP_PROTO(unsigned int cpu, u64 seq, pid_t pid, u32 notify, s64 stimulus_ns),
+
+    TP_ARGS(cpu, seq, pid, notify, stimulus_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, cpu)
+        __field(u64, seq)
+        __field(pid_t, pid)
+        __field(u32, notify)
+        __field(s64, stimulus_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu = cpu;
+        __entry->seq = seq;
+        __entry->pid = pid;
+        __entry->notify = notify;
+        __entry->stimulus_ns = stimulus_ns;
+    ),
+
+    TP_printk("cpu=%u seq=%llu pid=%d notify=%s stimulus=%lld",
+              __entry->cpu, __entry->seq, __entry->pid,
+              __print_symbolic(__entry->notify,
+                               { 0, "signal" }, { 1, "wait" }, { 2, "eventfd" }),
+              __entry->stimulus_ns)
+);
+
+// Реакция подтверждена процессом
+TRACE_EVENT(rta_reaction,
+
+    TP_PROTO(unsigned int cpu, u64 seq, s64 stimulus_ns, s64 ack_ns),
+
+    TP_ARGS(cpu, seq, stimulus_ns, ack_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, cpu)
+        __field(u64, seq)
+        __field(s64, stimulus_ns)
+        __field(s64, ack_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu = cpu;
+        __entry->seq = seq;
+        __entry->stimulus_ns = stimulus_ns;
+        __entry->ack_ns = ack_ns;
+    ),
+
+    TP_printk("cpu=%u seq=%llu stimulus=%lld ack=%lld reaction=%lld",
+              __entry->cpu, __entry->seq, __entry->stimulus_ns, __entry->ack_ns,
+              __entry->ack_ns - __entry->stimulus_ns)
+);
+
+#endif // _REACTION_TIME_TRACE_H
+
+// Заголовок находится вне дерева ядра: путь задается относительно каталога модуля (-I$(src))
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE reaction_time_trace
+
+#include <trace/define_trace.h>
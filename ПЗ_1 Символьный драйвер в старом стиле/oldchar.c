@@ -1,122 +1,488 @@
 #include <linux/module.h>    // Основные заголовки модуля
 #include <linux/fs.h>        // Файловая система
+#include <linux/cdev.h>      // Для регистрации символьных устройств
 #include <linux/uaccess.h>   // Для копирования данных из/в пользовательскую область
 #include <linux/slab.h>      // Для динамического выделения памяти
+#include <linux/vmalloc.h>   // Для буфера из нескольких страниц
+#include <linux/mutex.h>     // Для блокировок читателей и писателей
+#include <linux/spinlock.h>  // Для учета открытых файлов
+#include <linux/wait.h>      // Для очередей ожидания
+#include <linux/poll.h>      // Для poll()/select()/epoll
+#include <linux/log2.h>      // Для округления размера буфера
+#include <linux/uio.h>       // Для векторного ввода-вывода (iov_iter)
+#include <linux/splice.h>    // Для splice()/sendfile()
+#include <linux/mm.h>        // Для mmap()
+
+#include "oldchar.h"         // Общий с пользовательскими программами интерфейс
 
 #define DEVICE_NAME "oldchardev" // Имя устройства
-#define BUF_LEN 80               // Длина буфера
+#define MAX_MINORS 256           // Максимальное количество экземпляров устройства
 
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Символьный драйвер в старом стиле");
 
-static int major;                // Основной номер устройства
-static char message[BUF_LEN];    // Буфер для хранения сообщений
+static unsigned int buffer_size = 256 * 1024; // Размер кольцевого буфера в байтах
+module_param(buffer_size, uint, S_IRUGO);
+MODULE_PARM_DESC(buffer_size, "Размер кольцевого буфера в байтах (округляется до степени двойки)");
+
+static unsigned int minors = 4; // Количество экземпляров устройства
+module_param(minors, uint, S_IRUGO);
+MODULE_PARM_DESC(minors, "Количество экземпляров устройства (младших номеров)");
+
+// Экземпляр устройства: у каждого младшего номера свой буфер, свои блокировки и очереди ожидания.
+// Кольцевой буфер (FIFO): индексы свободно растут, позиция в буфере - индекс & (size - 1).
+// Читатель меняет только tail, писатель - только head, поэтому один читатель и один писатель
+// работают параллельно без общей блокировки. Индексы лежат в управляющей странице, которая вместе
+// с данными отображается в пользовательское пространство через mmap()
+struct oldchar_dev {
+    struct cdev cdev;                // Символьное устройство
+    struct oldchar_ring *ring;       // Управляющая страница, за ней - данные буфера
+    char *buf;                       // Данные буфера
+    unsigned int size;               // Размер буфера (степень двойки)
+    atomic_t writers;                // Количество открытых на запись файлов
+    spinlock_t open_lock;            // Защита users и writer_seen
+    unsigned int users;              // Количество открытых файлов
+    bool writer_seen;                // Писатель подключался, пока устройство открыто
+    struct mutex write_lock ____cacheline_aligned_in_smp; // Сериализация писателей
+    wait_queue_head_t write_queue;   // Ожидание свободного места
+    struct mutex read_lock ____cacheline_aligned_in_smp;  // Сериализация читателей
+    wait_queue_head_t read_queue;    // Ожидание данных
+};
+
+static dev_t first_dev;                     // Первый номер устройства
+static struct oldchar_dev **devs;           // Экземпляры устройства
 static struct class*  oldcharClass  = NULL; // Класс устройства
-static struct device* oldcharDevice = NULL; // Устройство
 
 // Прототипы функций
 static int     oldchar_open(struct inode *, struct file *);
 static int     oldchar_release(struct inode *, struct file *);
-static ssize_t oldchar_read(struct file *, char __user *, size_t, loff_t *);
-static ssize_t oldchar_write(struct file *, const char __user *, size_t, loff_t *);
+static ssize_t oldchar_read_iter(struct kiocb *, struct iov_iter *);
+static ssize_t oldchar_write_iter(struct kiocb *, struct iov_iter *);
+static __poll_t oldchar_poll(struct file *, poll_table *);
+static long    oldchar_ioctl(struct file *, unsigned int, unsigned long);
+static int     oldchar_mmap(struct file *, struct vm_area_struct *);
 
 // Описание операций файла
 static struct file_operations fops =
 {
+    .owner = THIS_MODULE,
     .open = oldchar_open,
-    .read = oldchar_read,
-    .write = oldchar_write,
+    .read_iter = oldchar_read_iter,             // read(), readv(), io_uring
+    .write_iter = oldchar_write_iter,           // write(), writev(), io_uring
+    .splice_read = generic_file_splice_read,    // splice()/sendfile() из устройства
+    .splice_write = iter_file_splice_write,     // splice() в устройство
+    .poll = oldchar_poll,
+    .unlocked_ioctl = oldchar_ioctl,            // Пробуждение ожидающих при работе через mmap()
+    .mmap = oldchar_mmap,                       // Общее с пользовательским пространством кольцо
+    .llseek = no_llseek,
     .release = oldchar_release,
 };
 
+// Количество байт в буфере; индексы доступны пользовательскому пространству на запись,
+// поэтому результат ограничивается размером буфера
+static unsigned int fifo_used(struct oldchar_dev *dev)
+{
+    unsigned int used = smp_load_acquire(&dev->ring->head) - smp_load_acquire(&dev->ring->tail);
+
+    return min(used, dev->size);
+}
+
+// Конец файла: писатель подключался и все писатели закрыли устройство. До первого писателя
+// пустой буфер означает ожидание, как у именованного канала, поэтому читатель может открыть
+// устройство раньше писателя
+static bool fifo_eof(struct oldchar_dev *dev)
+{
+    return READ_ONCE(dev->writer_seen) && !atomic_read(&dev->writers);
+}
+
+// Отметка ожидающей стороны перед сном: пользовательская сторона, изменив индекс, проверяет отметку
+// и вызывает OLDCHAR_IOC_WAKE. Полный барьер с обеих сторон исключает потерю пробуждения
+static void fifo_mark_waiting(__u32 *flag)
+{
+    WRITE_ONCE(*flag, 1);
+    smp_mb();
+}
+
+// Условия ожидания читателя и писателя. Отметка выставляется перед каждой проверкой:
+// OLDCHAR_IOC_WAKE снимает отметки, и ожидающий, чье условие еще не выполнено,
+// снова засыпает с отметкой, иначе следующее пробуждение было бы потеряно
+static bool fifo_reader_ready(struct oldchar_dev *dev)
+{
+    fifo_mark_waiting(&dev->ring->reader_waiting);
+    return fifo_used(dev) || fifo_eof(dev);
+}
+
+static bool fifo_writer_ready(struct oldchar_dev *dev)
+{
+    fifo_mark_waiting(&dev->ring->writer_waiting);
+    return fifo_used(dev) < dev->size;
+}
+
+// Удаление экземпляров устройства [0, count)
+static void oldchar_destroy_devs(unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        device_destroy(oldcharClass, first_dev + i); // Уничтожение устройства
+        cdev_del(&devs[i]->cdev);                    // Отмена регистрации устройства
+        vfree(devs[i]->ring);                        // Освобождение буфера
+        kfree(devs[i]);
+    }
+}
+
+// Создание экземпляра устройства с младшим номером minor
+static int oldchar_create_dev(unsigned int minor)
+{
+    struct oldchar_dev *dev;
+    struct device *device;
+    int ret;
+
+    dev = kzalloc(sizeof(*dev), GFP_KERNEL);
+    if (!dev) {
+        return -ENOMEM;
+    }
+    dev->size = roundup_pow_of_two(buffer_size);
+    dev->ring = vmalloc_user(PAGE_SIZE + dev->size); // Обнуленная память, пригодная для mmap()
+    if (!dev->ring) {
+        kfree(dev);
+        return -ENOMEM;
+    }
+    dev->buf = (char *)dev->ring + PAGE_SIZE;
+    dev->ring->size = dev->size;
+    dev->ring->data_offset = PAGE_SIZE;
+    atomic_set(&dev->writers, 0);
+    spin_lock_init(&dev->open_lock);
+    mutex_init(&dev->read_lock);
+    mutex_init(&dev->write_lock);
+    init_waitqueue_head(&dev->read_queue);
+    init_waitqueue_head(&dev->write_queue);
+
+    cdev_init(&dev->cdev, &fops);
+    dev->cdev.owner = THIS_MODULE;
+    ret = cdev_add(&dev->cdev, first_dev + minor, 1);
+    if (ret) {
+        goto free_dev;
+    }
+
+    // Создание узла /dev/oldchardev<minor>
+    device = device_create(oldcharClass, NULL, first_dev + minor, NULL, DEVICE_NAME "%u", minor);
+    if (IS_ERR(device)) {
+        ret = PTR_ERR(device);
+        cdev_del(&dev->cdev);
+        goto free_dev;
+    }
+    devs[minor] = dev;
+    return 0;
+
+free_dev:
+    vfree(dev->ring);
+    kfree(dev);
+    return ret;
+}
+
 // Функция инициализации модуля
 static int __init oldchar_init(void)
 {
-    // Регистрация устройства
-    major = register_chrdev(0, DEVICE_NAME, &fops);
-    if (major < 0) {
-        printk(KERN_ALERT "Не удалось зарегистрировать устройство: %d\n", major);
-        return major;
+    unsigned int i;
+    int ret;
+
+    if (buffer_size < PAGE_SIZE || buffer_size > (1U << 30)) {
+        printk(KERN_ALERT "Недопустимый размер буфера: %u\n", buffer_size);
+        return -EINVAL;
+    }
+    if (!minors || minors > MAX_MINORS) {
+        printk(KERN_ALERT "Недопустимое количество устройств: %u\n", minors);
+        return -EINVAL;
+    }
+    devs = kcalloc(minors, sizeof(*devs), GFP_KERNEL);
+    if (!devs) {
+        return -ENOMEM;
+    }
+
+    // Выделение диапазона номеров устройства
+    ret = alloc_chrdev_region(&first_dev, 0, minors, DEVICE_NAME);
+    if (ret < 0) {
+        kfree(devs);
+        printk(KERN_ALERT "Не удалось зарегистрировать устройство: %d\n", ret);
+        return ret;
     }
 
     // Создание класса устройства
     oldcharClass = class_create(THIS_MODULE, "chardrv");
     if (IS_ERR(oldcharClass)) {
-        unregister_chrdev(major, DEVICE_NAME);
+        unregister_chrdev_region(first_dev, minors);
+        kfree(devs);
         printk(KERN_ALERT "Не удалось создать класс устройства\n");
         return PTR_ERR(oldcharClass);
     }
 
-    // Создание устройства
-    oldcharDevice = device_create(oldcharClass, NULL, MKDEV(major, 0), NULL, DEVICE_NAME);
-    if (IS_ERR(oldcharDevice)) {
-        class_destroy(oldcharClass);
-        unregister_chrdev(major, DEVICE_NAME);
-        printk(KERN_ALERT "Не удалось создать устройство\n");
-        return PTR_ERR(oldcharDevice);
+    // Создание экземпляров устройства
+    for (i = 0; i < minors; i++) {
+        ret = oldchar_create_dev(i);
+        if (ret) {
+            oldchar_destroy_devs(i);
+            class_destroy(oldcharClass);
+            unregister_chrdev_region(first_dev, minors);
+            kfree(devs);
+            printk(KERN_ALERT "Не удалось создать устройство %u: %d\n", i, ret);
+            return ret;
+        }
     }
 
-    printk(KERN_INFO "Устройство %s успешно зарегистрировано с номером %d\n", DEVICE_NAME, major);
+    printk(KERN_INFO "Устройство %s успешно зарегистрировано с номером %d: %u экземпляров, буфер %u байт\n",
+           DEVICE_NAME, MAJOR(first_dev), minors, devs[0]->size);
     return 0;
 }
 
 // Функция очистки модуля
 static void __exit oldchar_exit(void)
 {
-    device_destroy(oldcharClass, MKDEV(major, 0)); // Уничтожение устройства
-    class_unregister(oldcharClass);                 // Отмена регистрации класса
+    oldchar_destroy_devs(minors);                   // Уничтожение экземпляров устройства
     class_destroy(oldcharClass);                    // Уничтожение класса
-    unregister_chrdev(major, DEVICE_NAME);         // Отмена регистрации устройства
+    unregister_chrdev_region(first_dev, minors);    // Освобождение номеров устройства
+    kfree(devs);
     printk(KERN_INFO "Устройство %s успешно удалено\n", DEVICE_NAME);
 }
 
 // Функция открытия устройства
 static int oldchar_open(struct inode *inode, struct file *file)
 {
-    printk(KERN_INFO "Устройство %s открыто\n", DEVICE_NAME);
+    struct oldchar_dev *dev = container_of(inode->i_cdev, struct oldchar_dev, cdev);
+
+    file->private_data = dev; // Экземпляр устройства, соответствующий младшему номеру
+    stream_open(inode, file); // FIFO без позиции: *offset не используется
+    file->f_mode |= FMODE_NOWAIT; // Поддержка неблокирующих запросов io_uring (IOCB_NOWAIT)
+    spin_lock(&dev->open_lock);
+    dev->users++;
+    if (file->f_mode & FMODE_WRITE) {
+        atomic_inc(&dev->writers);
+        WRITE_ONCE(dev->writer_seen, true);
+    }
+    spin_unlock(&dev->open_lock);
+    printk(KERN_INFO "Устройство %s%u открыто\n", DEVICE_NAME, iminor(inode));
     return 0;
 }
 
 // Функция закрытия устройства
 static int oldchar_release(struct inode *inode, struct file *file)
 {
-    printk(KERN_INFO "Устройство %s закрыто\n", DEVICE_NAME);
+    struct oldchar_dev *dev = file->private_data;
+    bool eof;
+
+    spin_lock(&dev->open_lock);
+    eof = (file->f_mode & FMODE_WRITE) && atomic_dec_and_test(&dev->writers);
+    if (!--dev->users) {
+        WRITE_ONCE(dev->writer_seen, false); // Следующий читатель снова ждет писателя
+    }
+    spin_unlock(&dev->open_lock);
+    if (eof) {
+        wake_up_interruptible(&dev->read_queue); // Ожидающие читатели получат конец файла
+    }
+    printk(KERN_INFO "Устройство %s%u закрыто\n", DEVICE_NAME, iminor(inode));
     return 0;
 }
 
-// Функция чтения из устройства
-static ssize_t oldchar_read(struct file *file, char __user *buffer, size_t len, loff_t *offset)
+// Запрос не должен блокироваться (O_NONBLOCK или IOCB_NOWAIT от io_uring)
+static bool oldchar_nowait(struct kiocb *iocb)
 {
-    int bytes_read = 0;
+    return (iocb->ki_filp->f_flags & O_NONBLOCK) || (iocb->ki_flags & IOCB_NOWAIT);
+}
+
+// Захват блокировки стороны: неблокирующий запрос не ждет, пока ее держит другой читатель (писатель)
+static int oldchar_lock(struct mutex *lock, struct kiocb *iocb)
+{
+    if (oldchar_nowait(iocb)) {
+        return mutex_trylock(lock) ? 0 : -EAGAIN;
+    }
+    return mutex_lock_interruptible(lock) ? -ERESTARTSYS : 0;
+}
+
+// Копирование len байт из буфера, начиная с индекса tail, в итератор: не более двух блоков
+static size_t fifo_copy_out(struct oldchar_dev *dev, unsigned int tail, size_t len, struct iov_iter *to)
+{
+    unsigned int pos = tail & (dev->size - 1);
+    size_t first = min_t(size_t, len, dev->size - pos);
+    size_t copied = copy_to_iter(dev->buf + pos, first, to);
+
+    if (copied == first && len > first) {
+        copied += copy_to_iter(dev->buf, len - first, to);
+    }
+    return copied;
+}
+
+// Копирование len байт из итератора в буфер, начиная с индекса head: не более двух блоков
+static size_t fifo_copy_in(struct oldchar_dev *dev, unsigned int head, size_t len, struct iov_iter *from)
+{
+    unsigned int pos = head & (dev->size - 1);
+    size_t first = min_t(size_t, len, dev->size - pos);
+    size_t copied = copy_from_iter(dev->buf + pos, first, from);
 
-    // Если нет данных для чтения
-    if (*message == 0) {
+    if (copied == first && len > first) {
+        copied += copy_from_iter(dev->buf, len - first, from);
+    }
+    return copied;
+}
+
+// Функция чтения из устройства: read(), readv(), io_uring и splice()
+static ssize_t oldchar_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+    struct oldchar_dev *dev = iocb->ki_filp->private_data;
+    unsigned int tail;
+    size_t bytes_read;
+    int ret;
+
+    if (!iov_iter_count(to)) {
         return 0;
     }
+    ret = oldchar_lock(&dev->read_lock, iocb);
+    if (ret) {
+        return ret;
+    }
 
-    // Копирование данных в пользовательский буфер
-    while (len && *message) {
-        put_user(*(message++), buffer++);
-        len--;
-        bytes_read++;
+    // Ожидание данных, в том числе подключения первого писателя
+    while (!fifo_used(dev)) {
+        mutex_unlock(&dev->read_lock);
+        if (fifo_eof(dev)) {
+            return 0;
+        }
+        if (oldchar_nowait(iocb)) {
+            return -EAGAIN;
+        }
+        if (wait_event_interruptible(dev->read_queue, fifo_reader_ready(dev))) {
+            return -ERESTARTSYS;
+        }
+        ret = oldchar_lock(&dev->read_lock, iocb);
+        if (ret) {
+            return ret;
+        }
     }
 
-    printk(KERN_INFO "Прочитано %d байт(ов) из устройства %s\n", bytes_read, DEVICE_NAME);
+    tail = READ_ONCE(dev->ring->tail);
+    bytes_read = fifo_copy_out(dev, tail, min_t(size_t, iov_iter_count(to), fifo_used(dev)), to);
+    smp_store_release(&dev->ring->tail, tail + bytes_read); // Освобождение прочитанного места
+    mutex_unlock(&dev->read_lock);
+
+    if (!bytes_read) {
+        return -EFAULT;
+    }
+    wake_up_interruptible(&dev->write_queue);
     return bytes_read;
 }
 
-// Функция записи в устройство
-static ssize_t oldchar_write(struct file *file, const char __user *buffer, size_t len, loff_t *offset)
+// Функция записи в устройство: write(), writev(), io_uring и splice()
+static ssize_t oldchar_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+    struct oldchar_dev *dev = iocb->ki_filp->private_data;
+    unsigned int head;
+    size_t bytes_written;
+    int ret;
+
+    if (!iov_iter_count(from)) {
+        return 0;
+    }
+    ret = oldchar_lock(&dev->write_lock, iocb);
+    if (ret) {
+        return ret;
+    }
+
+    // Ожидание свободного места
+    while (fifo_used(dev) == dev->size) {
+        mutex_unlock(&dev->write_lock);
+        if (oldchar_nowait(iocb)) {
+            return -EAGAIN;
+        }
+        if (wait_event_interruptible(dev->write_queue, fifo_writer_ready(dev))) {
+            return -ERESTARTSYS;
+        }
+        ret = oldchar_lock(&dev->write_lock, iocb);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    head = READ_ONCE(dev->ring->head);
+    bytes_written = fifo_copy_in(dev, head, min_t(size_t, iov_iter_count(from), dev->size - fifo_used(dev)), from);
+    smp_store_release(&dev->ring->head, head + bytes_written); // Публикация записанных данных
+    mutex_unlock(&dev->write_lock);
+
+    if (!bytes_written) {
+        return -EFAULT;
+    }
+    wake_up_interruptible(&dev->read_queue);
+    return bytes_written;
+}
+
+// Готовность устройства для poll()/select()/epoll
+static __poll_t oldchar_poll(struct file *file, poll_table *wait)
+{
+    struct oldchar_dev *dev = file->private_data;
+    __poll_t mask = 0;
+    unsigned int used;
+
+    poll_wait(file, &dev->read_queue, wait);
+    poll_wait(file, &dev->write_queue, wait);
+
+    // Перед ответом "не готово" ожидающая сторона отмечается для пользовательского писателя/читателя
+    used = fifo_used(dev);
+    if (!used) {
+        fifo_mark_waiting(&dev->ring->reader_waiting);
+        used = fifo_used(dev);
+    } else if (used == dev->size) {
+        fifo_mark_waiting(&dev->ring->writer_waiting);
+        used = fifo_used(dev);
+    }
+    if (used) {
+        mask |= EPOLLIN | EPOLLRDNORM;
+    } else if (fifo_eof(dev)) {
+        mask |= EPOLLHUP; // Данных нет, и все писатели закрыли устройство
+    }
+    if (used < dev->size) {
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    }
+    return mask;
+}
+
+// Управляющие команды
+static long oldchar_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct oldchar_dev *dev = file->private_data;
+
+    switch (cmd) {
+        case OLDCHAR_IOC_WAKE:
+            // Пользовательская сторона изменила индексы: пробуждение ожидающих в read/write/poll
+            WRITE_ONCE(dev->ring->reader_waiting, 0);
+            WRITE_ONCE(dev->ring->writer_waiting, 0);
+            wake_up_interruptible_all(&dev->read_queue);
+            wake_up_interruptible_all(&dev->write_queue);
+            return 0;
+        case OLDCHAR_IOC_INFO: {
+            struct oldchar_ring_info info = {
+                .map_size = PAGE_SIZE + dev->size,
+                .size = dev->size,
+                .data_offset = PAGE_SIZE,
+            };
+
+            if (copy_to_user((void __user *)arg, &info, sizeof(info))) {
+                return -EFAULT;
+            }
+            return 0;
+        }
+        default:
+            return -ENOTTY;
+    }
+}
+
+// Отображение управляющей страницы и данных буфера в пользовательское пространство
+static int oldchar_mmap(struct file *file, struct vm_area_struct *vma)
 {
-    int i;
-    for (i = 0; i < len && i < BUF_LEN; i++) {
-        get_user(message[i], buffer + i);
+    struct oldchar_dev *dev = file->private_data;
+
+    if (vma->vm_pgoff || vma->vm_end - vma->vm_start > PAGE_SIZE + dev->size) {
+        return -EINVAL;
     }
-    message[i] = '\0'; // Завершение строки
-    printk(KERN_INFO "Записано в устройство %s: %s\n", DEVICE_NAME, message);
-    return i;
+    return remap_vmalloc_range(vma, dev->ring, 0);
 }
 
 module_init(oldchar_init);  // Инициализация модуля
 module_exit(oldchar_exit);  // Очистка модуля
-
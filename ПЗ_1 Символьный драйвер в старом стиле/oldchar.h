@@ -0,0 +1,35 @@
+#ifndef OLDCHAR_H
+#define OLDCHAR_H
+
+// Общий для модуля и пользовательских программ интерфейс устройства oldchardev
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define OLDCHAR_RING_ALIGN 128 // Индексы записи и чтения находятся в разных кэш-линиях
+
+// Управляющая страница кольца (начало области mmap()); данные - с data_offset.
+// Индексы свободно растут, позиция в данных - индекс & (size - 1).
+// Писатель публикует head, читатель - tail (release), противоположный индекс читается с acquire
+struct oldchar_ring {
+    __u32 head;                                 // Индекс записи
+    __u8 pad0[OLDCHAR_RING_ALIGN - sizeof(__u32)];
+    __u32 tail;                                 // Индекс чтения
+    __u8 pad1[OLDCHAR_RING_ALIGN - sizeof(__u32)];
+    __u32 reader_waiting;                       // Читатель спит в ядре: после записи нужен OLDCHAR_IOC_WAKE
+    __u32 writer_waiting;                       // Писатель спит в ядре: после чтения нужен OLDCHAR_IOC_WAKE
+    __u32 size;                                 // Размер данных (степень двойки)
+    __u32 data_offset;                          // Смещение данных от начала области
+};
+
+// Параметры области mmap()
+struct oldchar_ring_info {
+    __u64 map_size;    // Размер области (управляющая страница и данные)
+    __u32 size;        // Размер данных (степень двойки)
+    __u32 data_offset; // Смещение данных от начала области
+};
+
+#define OLDCHAR_IOC_WAKE _IO('o', 1)                             // Пробуждение ожидающих в ядре
+#define OLDCHAR_IOC_INFO _IOR('o', 2, struct oldchar_ring_info)  // Параметры области mmap()
+
+#endif // OLDCHAR_H
@@ -1,50 +1,1201 @@
-#include <linux/init.h>      
-#include <linux/module.h>     
-#include <linux/version.h>    
-#include <linux/sched.h>         
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/version.h>
+#include <linux/sched.h>
 #include <linux/kthread.h>
-#include <linux/kernel.h>      
-#include <linux/delay.h>        
-#include <linux/moduleparam.h>  
+#include <linux/kernel.h>
+#include <linux/delay.h>
+#include <linux/moduleparam.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/idr.h>
+#include <linux/cpu.h>
+#include <linux/cpuhotplug.h>
+#include <linux/kobject.h>
+#include <linux/sysfs.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
+#include <linux/rcupdate.h>
+
+#include "sleep_module.h"
 
 MODULE_LICENSE("GPL");          // Лицензия модуля: GNU Public License.
 MODULE_DESCRIPTION("Модуль ядра с параметрами частоты и сообщения");
 
-static struct task_struct *task; // Указатель на поток
+#define DEVICE_NAME "sleep_module" // Имя символьного устройства
+#define HEARTBEAT_ID 0 // Номер задания, создаваемого по параметрам модуля
+#define MAX_MESSAGE_LEN 256 // Наибольшая длина сообщения задания
+#define MIN_PERIOD_NS 10000 // Наименьший период задания (10 мкс)
+
 static int frequency = 1; // Частота в секундах
+static unsigned long period_ns; // Период в наносекундах (если задан, заменяет frequency)
 static char *message = "Привет, мир!"; // Сообщение по умолчанию
+static bool enabled = true; // Вывод сообщения, заданного параметрами
+static unsigned int workers; // Количество рабочих потоков (0 - по одному на процессор)
+static unsigned long slack_ns; // Допустимое запаздывание пробуждения для объединения сроков
+static char *output = "printk"; // Способ вывода: printk или ring
+static unsigned int ring_entries = 4096; // Емкость кольца вывода рабочего потока
+
+// Параметры задания 0 изменяются через /sys/module/sleep_module/parameters без перезагрузки модуля
+static const struct kernel_param_ops frequency_ops;
+static const struct kernel_param_ops period_ns_ops;
+static const struct kernel_param_ops message_ops;
+static const struct kernel_param_ops enabled_ops;
 
 // Определение параметров модуля
-module_param(frequency, int, S_IRUGO);
+module_param_cb(frequency, &frequency_ops, &frequency, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(frequency, "Частота вывода сообщения в секундах");
 
-module_param(message, charp, S_IRUGO);
+module_param_cb(period_ns, &period_ns_ops, &period_ns, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(period_ns, "Период вывода сообщения в наносекундах (заменяет frequency)");
+
+module_param_cb(message, &message_ops, &message, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(message, "Сообщение для вывода");
 
+module_param_cb(enabled, &enabled_ops, &enabled, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(enabled, "Вывод сообщения, заданного параметрами (0 - приостановлен)");
+
+module_param(workers, uint, S_IRUGO);
+MODULE_PARM_DESC(workers, "Количество рабочих потоков (0 - по одному на процессор)");
+
+module_param(slack_ns, ulong, S_IRUGO);
+MODULE_PARM_DESC(slack_ns, "Допустимое запаздывание пробуждения в наносекундах для объединения сроков");
+
+module_param(output, charp, S_IRUGO);
+MODULE_PARM_DESC(output, "Способ вывода: printk (отладочный) или ring (кольца, читаемые через устройство)");
+
+module_param(ring_entries, uint, S_IRUGO);
+MODULE_PARM_DESC(ring_entries, "Емкость кольца вывода рабочего потока (степень двойки)");
+
+// Статистика точности периода: запаздывание выполнения задания относительно абсолютного срока
+struct emit_stats {
+    u64 wakeups;       // Количество пробуждений рабочего потока
+    u64 iterations;    // Количество выводов
+    u64 missed;        // Пропущенные сроки (задание опоздало больше чем на период)
+    u64 last_lateness; // Запаздывание последнего вывода, нс
+    u64 sum_lateness;  // Сумма запаздываний, нс
+    u64 max_lateness;  // Наибольшее запаздывание, нс
+};
+
+// Сообщение задания; заменяется целиком, старое освобождается после периода RCU
+struct sm_message {
+    struct rcu_head rcu;
+    char text[];
+};
+
+// Периодическое задание
+struct sm_job {
+    u32 id;                          // Номер задания
+    u64 period;                      // Период, нс (новое значение действует со следующего срока)
+    ktime_t next;                    // Абсолютный срок следующего вывода
+    unsigned int heap_index;         // Позиция в куче рабочего потока
+    struct sm_worker *worker;        // Рабочий поток, обслуживающий задание
+    struct sm_message __rcu *msg;    // Сообщение
+};
+
+// Стоимость изменения параметров во время работы
+struct update_stats {
+    u64 count;   // Количество изменений
+    u64 last_ns; // Длительность последнего изменения
+    u64 max_ns;  // Наибольшая длительность изменения
+};
+
+// Рабочий поток: обслуживает двоичную кучу заданий, упорядоченную по ближайшему сроку.
+// Один поток спит до срока вершины кучи и за одно пробуждение выполняет все наступившие сроки
+struct sm_worker {
+    struct task_struct *task;  // Поток
+    unsigned int cpu;          // Процессор привязанного потока (UINT_MAX - несвязанный)
+    bool online;               // Принимает задания (под jobs_lock); false - процессор выключен
+    struct mutex lock;         // Защита кучи
+    struct sm_job **heap;      // Куча заданий
+    unsigned int nr;           // Количество заданий
+    unsigned int cap;          // Емкость кучи
+    atomic_t kicked;           // Куча изменилась - срок сна нужно пересчитать
+    spinlock_t stats_lock;     // Согласованное чтение 64-битных полей через sysfs
+    struct emit_stats stats;   // Статистика, пишет только поток
+    struct sm_ring_ctrl *ring; // Кольцо вывода (единственный писатель - поток)
+    u32 ring_head;             // Индекс записи; страница кольца доступна пользователю на запись,
+                               // поэтому ядро читает head только отсюда (release)
+    u64 ring_dropped;          // Количество отброшенных записей
+};
+
+static struct sm_worker *worker_pool; // Рабочие потоки
+static unsigned int nr_workers; // Количество рабочих потоков
+static atomic_t next_worker = ATOMIC_INIT(0); // Распределение заданий по кругу
+static DEFINE_IDR(jobs); // Задания по номерам
+static DEFINE_MUTEX(jobs_lock); // Защита таблицы заданий
+static struct kobject *sleep_kobj; // Каталог /sys/kernel/sleep_module
+static bool output_ring; // Вывод в кольца вместо printk
+static size_t ring_map_size; // Размер области mmap() одного кольца
+static int major; // Номер символьного устройства
+static DECLARE_WAIT_QUEUE_HEAD(out_wait); // Ожидание записей в кольцах
+static DEFINE_MUTEX(out_read_lock); // Один читатель колец через read()
+static bool sm_running; // Модуль инициализирован: изменения параметров применяются к заданию 0
+static DEFINE_SPINLOCK(update_lock); // Защита update
+static struct update_stats update; // Стоимость изменения параметров
+static enum cpuhp_state hp_state; // Динамическое состояние CPU hotplug (потоки по процессорам)
+
+// Период в наносекундах
+static u64 emit_period(void) {
+    return period_ns ? period_ns : (u64)frequency * NSEC_PER_SEC;
+}
+
+// Параметры задают допустимый период: меньший поток не успевал бы спать между сроками
+static bool emit_period_valid(void) {
+    return period_ns ? period_ns >= MIN_PERIOD_NS : frequency > 0;
+}
+
+// Операции двоичной кучи; вызываются под worker->lock
+static void heap_set(struct sm_worker *w, unsigned int i, struct sm_job *job) {
+    w->heap[i] = job;
+    job->heap_index = i;
+}
+
+static void heap_sift_up(struct sm_worker *w, unsigned int i) {
+    struct sm_job *job = w->heap[i];
+
+    while (i) {
+        unsigned int parent = (i - 1) / 2;
+
+        if (!ktime_before(job->next, w->heap[parent]->next)) {
+            break;
+        }
+        heap_set(w, i, w->heap[parent]);
+        i = parent;
+    }
+    heap_set(w, i, job);
+}
+
+static void heap_sift_down(struct sm_worker *w, unsigned int i) {
+    struct sm_job *job = w->heap[i];
+
+    for (;;) {
+        unsigned int child = 2 * i + 1;
+
+        if (child >= w->nr) {
+            break;
+        }
+        if (child + 1 < w->nr && ktime_before(w->heap[child + 1]->next, w->heap[child]->next)) {
+            child++;
+        }
+        if (!ktime_before(w->heap[child]->next, job->next)) {
+            break;
+        }
+        heap_set(w, i, w->heap[child]);
+        i = child;
+    }
+    heap_set(w, i, job);
+}
+
+static int heap_push(struct sm_worker *w, struct sm_job *job) {
+    if (w->nr == w->cap) {
+        unsigned int cap = max(2 * w->cap, 64U);
+        struct sm_job **heap = krealloc(w->heap, cap * sizeof(*heap), GFP_KERNEL);
+
+        if (!heap) {
+            return -ENOMEM;
+        }
+        w->heap = heap;
+        w->cap = cap;
+    }
+    heap_set(w, w->nr++, job);
+    heap_sift_up(w, job->heap_index);
+    return 0;
+}
+
+static void heap_remove(struct sm_worker *w, struct sm_job *job) {
+    unsigned int i = job->heap_index;
+
+    if (--w->nr == i) {
+        return; // Удален последний элемент
+    }
+    heap_set(w, i, w->heap[w->nr]);
+    heap_sift_down(w, i);
+    heap_sift_up(w, w->heap[i]->heap_index);
+}
+
+// Пересчет срока сна рабочего потока после изменения кучи
+static void worker_kick(struct sm_worker *w) {
+    atomic_set(&w->kicked, 1);
+    wake_up_process(w->task);
+}
+
+// Запись сообщения в кольцо рабочего потока; при заполнении кольца запись отбрасывается
+static void ring_push(struct sm_worker *w, struct sm_job *job, ktime_t now) {
+    struct sm_ring_ctrl *ring = w->ring;
+    struct sm_record *rec;
+    u32 head = w->ring_head;
+    int len;
+
+    if (head - smp_load_acquire(&ring->tail) >= ring_entries) {
+        WRITE_ONCE(w->ring_dropped, w->ring_dropped + 1); // Кольцо заполнено
+        WRITE_ONCE(ring->dropped, w->ring_dropped);
+        return;
+    }
+    rec = (struct sm_record *)((char *)ring + PAGE_SIZE) + (head & (ring_entries - 1));
+    rec->time_ns = ktime_to_ns(now);
+    rec->id = job->id;
+    rcu_read_lock();
+    len = scnprintf(rec->text, sizeof(rec->text) - 1, "[%u] %s", job->id, rcu_dereference(job->msg)->text);
+    rcu_read_unlock();
+    rec->text[len++] = '\n';
+    rec->len = len;
+    smp_store_release(&w->ring_head, head + 1); // Публикация записи read()
+    smp_store_release(&ring->head, head + 1);   // и читателю через mmap()
+}
+
+// Вывод сообщения задания
+static void job_emit(struct sm_worker *w, struct sm_job *job, ktime_t now) {
+    if (output_ring) {
+        ring_push(w, job, now);
+        return;
+    }
+    rcu_read_lock();
+    printk(KERN_INFO "Сообщение от модуля [%u]: %s\n", job->id, rcu_dereference(job->msg)->text);
+    rcu_read_unlock();
+}
+
+// Выполнение всех заданий, срок которых наступил к моменту now; вызывается под w->lock.
+// Возвращает количество выводов
+static u64 worker_run_due(struct sm_worker *w, ktime_t now) {
+    struct emit_stats batch = {0};
+    u64 lateness, missed;
+
+    while (w->nr && !ktime_after(w->heap[0]->next, now)) {
+        struct sm_job *job = w->heap[0];
+        u64 period = READ_ONCE(job->period);
+
+        lateness = ktime_to_ns(ktime_sub(now, job->next));
+        job_emit(w, job, now);
+
+        // Следующий срок от предыдущего; опоздание больше периода отбрасывает пропущенные сроки
+        job->next = ktime_add_ns(job->next, period);
+        missed = 0;
+        if (!ktime_after(job->next, now)) {
+            missed = div64_u64(ktime_to_ns(ktime_sub(now, job->next)), period) + 1;
+            job->next = ktime_add_ns(job->next, missed * period);
+        }
+        heap_sift_down(w, 0);
+
+        batch.iterations++;
+        batch.missed += missed;
+        batch.last_lateness = lateness;
+        batch.sum_lateness += lateness;
+        batch.max_lateness = max(batch.max_lateness, lateness);
+    }
+
+    // Статистика обновляется один раз за пробуждение
+    spin_lock(&w->stats_lock);
+    w->stats.wakeups++;
+    if (batch.iterations) {
+        w->stats.iterations += batch.iterations;
+        w->stats.missed += batch.missed;
+        w->stats.last_lateness = batch.last_lateness;
+        w->stats.sum_lateness += batch.sum_lateness;
+        w->stats.max_lateness = max(w->stats.max_lateness, batch.max_lateness);
+    }
+    spin_unlock(&w->stats_lock);
+    return batch.iterations;
+}
+
 static int thread_fn(void *data) {
-    // Функция потока, которая будет выполняться
+    // Функция рабочего потока, которая будет выполняться
+    struct sm_worker *w = data;
+    ktime_t deadline;
+    bool idle;
+    u64 emitted;
+
     while (!kthread_should_stop()) {
-        printk(KERN_INFO "Сообщение от модуля: %s\n", message);
-        ssleep(frequency); // Задержка на заданное количество секунд
+        if (kthread_should_park()) {
+            kthread_parkme(); // Процессор выключается; задания перенесены на другие потоки
+            continue;
+        }
+        mutex_lock(&w->lock);
+        idle = !w->nr;
+        if (!idle) {
+            deadline = w->heap[0]->next; // Ближайший срок
+        }
+        mutex_unlock(&w->lock);
+
+        // Сон до абсолютного срока вершины кучи или до изменения кучи
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (kthread_should_stop() || kthread_should_park() || atomic_xchg(&w->kicked, 0)) {
+            __set_current_state(TASK_RUNNING);
+            continue;
+        }
+        if (idle) {
+            schedule();
+            continue;
+        }
+        if (schedule_hrtimeout_range(&deadline, slack_ns, HRTIMER_MODE_ABS)) {
+            continue; // Пробуждение до срока - пересчет срока и проверка условия выхода
+        }
+
+        mutex_lock(&w->lock);
+        emitted = worker_run_due(w, ktime_get());
+        mutex_unlock(&w->lock);
+
+        // Одно пробуждение читателя на пакет записей и только если он ждет
+        if (output_ring && emitted && wq_has_sleeper(&out_wait)) {
+            wake_up_interruptible(&out_wait);
+        }
+    }
+    return 0;
+}
+
+// Копия сообщения длиной len
+static struct sm_message *message_alloc(const char *text, size_t len) {
+    struct sm_message *msg;
+
+    if (len > MAX_MESSAGE_LEN) {
+        return NULL;
+    }
+    msg = kzalloc(struct_size(msg, text, len + 1), GFP_KERNEL);
+    if (msg) {
+        memcpy(msg->text, text, len);
+    }
+    return msg;
+}
+
+static void job_free(struct sm_job *job) {
+    kfree(rcu_dereference_protected(job->msg, 1));
+    kfree(job);
+}
+
+// Следующий по кругу поток, принимающий задания; вызывается под jobs_lock
+static struct sm_worker *worker_next(void) {
+    unsigned int n;
+
+    for (n = 0; n < nr_workers; n++) {
+        struct sm_worker *w = &worker_pool[(unsigned int)atomic_inc_return(&next_worker) % nr_workers];
+
+        if (w->online) {
+            return w;
+        }
+    }
+    return NULL;
+}
+
+// Добавление задания с заданным номером
+static int job_add(u32 id, u64 period, const char *msg, size_t len) {
+    struct sm_worker *w;
+    struct sm_job *job;
+    ktime_t now;
+    int ret;
+
+    if (period < MIN_PERIOD_NS || len > MAX_MESSAGE_LEN || id > INT_MAX) {
+        return -EINVAL; // Номера idr ограничены INT_MAX
+    }
+    job = kzalloc(sizeof(*job), GFP_KERNEL);
+    if (!job) {
+        return -ENOMEM;
+    }
+    job->id = id;
+    job->period = period;
+    RCU_INIT_POINTER(job->msg, message_alloc(msg, len));
+    if (!rcu_access_pointer(job->msg)) {
+        kfree(job);
+        return -ENOMEM;
+    }
+
+    // Первый срок - ближайшее кратное периоду время: задания с одинаковым периодом
+    // срабатывают вместе и обслуживаются за одно пробуждение
+    now = ktime_get();
+    job->next = ns_to_ktime((div64_u64(ktime_to_ns(now), period) + 1) * period);
+
+    mutex_lock(&jobs_lock);
+    ret = idr_alloc(&jobs, job, id, id + 1, GFP_KERNEL);
+    if (ret < 0) {
+        mutex_unlock(&jobs_lock);
+        job_free(job);
+        return ret == -ENOSPC ? -EEXIST : ret; // Номер занят
+    }
+
+    w = worker_next();
+    if (!w) {
+        ret = -ENODEV; // Процессоры всех потоков выключены
+    } else {
+        job->worker = w;
+        mutex_lock(&w->lock);
+        ret = heap_push(w, job);
+        mutex_unlock(&w->lock);
+    }
+    if (ret) {
+        idr_remove(&jobs, id);
+        mutex_unlock(&jobs_lock);
+        job_free(job);
+        return ret;
+    }
+    mutex_unlock(&jobs_lock);
+
+    if (job->heap_index == 0) {
+        worker_kick(w); // Новый ближайший срок
+    }
+    return 0;
+}
+
+// Удаление задания
+static int job_del(u32 id) {
+    struct sm_job *job;
+
+    mutex_lock(&jobs_lock);
+    job = idr_remove(&jobs, id);
+    if (job) {
+        mutex_lock(&job->worker->lock);
+        heap_remove(job->worker, job);
+        mutex_unlock(&job->worker->lock);
+    }
+    mutex_unlock(&jobs_lock);
+    if (!job) {
+        return -ENOENT;
+    }
+    job_free(job); // Поток выполняет задания только под worker->lock
+    return 0;
+}
+
+// Новый период задания; действует со следующего срока, поток не перезапускается
+static int job_set_period(u32 id, u64 period) {
+    struct sm_job *job;
+
+    if (period < MIN_PERIOD_NS) {
+        return -EINVAL;
+    }
+    mutex_lock(&jobs_lock);
+    job = idr_find(&jobs, id);
+    if (job) {
+        WRITE_ONCE(job->period, period);
+    }
+    mutex_unlock(&jobs_lock);
+    return job ? 0 : -ENOENT;
+}
+
+// Замена сообщения задания; поток читает сообщение под rcu_read_lock() без блокировок
+static int job_set_message(u32 id, const char *text, size_t len) {
+    struct sm_message *msg = message_alloc(text, len), *old;
+    struct sm_job *job;
+
+    if (!msg) {
+        return len > MAX_MESSAGE_LEN ? -EINVAL : -ENOMEM;
+    }
+    mutex_lock(&jobs_lock);
+    job = idr_find(&jobs, id);
+    if (!job) {
+        mutex_unlock(&jobs_lock);
+        kfree(msg);
+        return -ENOENT;
+    }
+    old = rcu_replace_pointer(job->msg, msg, lockdep_is_held(&jobs_lock));
+    mutex_unlock(&jobs_lock);
+    kfree_rcu(old, rcu); // Освобождение после завершения текущих читателей
+    return 0;
+}
+
+// Учет длительности изменения параметра, начатого в момент start
+static void update_account(ktime_t start) {
+    u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    spin_lock(&update_lock);
+    update.count++;
+    update.last_ns = ns;
+    update.max_ns = max(update.max_ns, ns);
+    spin_unlock(&update_lock);
+}
+
+// Применение нового периода к заданию 0; вызывается под kernel_param_lock
+static int heartbeat_apply_period(void) {
+    ktime_t start = ktime_get();
+    int ret;
+
+    if (!sm_running || !enabled) {
+        return 0; // Период будет использован при создании задания
+    }
+    ret = job_set_period(HEARTBEAT_ID, emit_period());
+    update_account(start);
+    return ret == -ENOENT ? 0 : ret;
+}
+
+static int frequency_set(const char *val, const struct kernel_param *kp) {
+    int old = frequency, ret;
+
+    ret = param_set_int(val, kp);
+    if (ret) {
+        return ret;
+    }
+    if (!emit_period_valid()) {
+        frequency = old;
+        return -EINVAL;
+    }
+    ret = heartbeat_apply_period();
+    if (ret) {
+        frequency = old; // Параметр остается согласованным с заданием
+    }
+    return ret;
+}
+
+static int period_ns_set(const char *val, const struct kernel_param *kp) {
+    unsigned long old = period_ns;
+    int ret;
+
+    ret = param_set_ulong(val, kp);
+    if (ret) {
+        return ret;
+    }
+    if (!emit_period_valid()) {
+        period_ns = old;
+        return -EINVAL;
+    }
+    ret = heartbeat_apply_period();
+    if (ret) {
+        period_ns = old;
+    }
+    return ret;
+}
+
+static int message_set(const char *val, const struct kernel_param *kp) {
+    size_t len = strcspn(val, "\n");
+    ktime_t start = ktime_get();
+    char *old;
+    int ret;
+
+    if (len > MAX_MESSAGE_LEN) {
+        return -EINVAL;
+    }
+    old = kstrdup(message, GFP_KERNEL); // Для восстановления при ошибке изменения задания
+    if (!old) {
+        return -ENOMEM;
+    }
+    ret = param_set_charp(val, kp); // Копия для чтения параметра и повторного создания задания
+    if (!ret) {
+        message[len] = '\0'; // Без перевода строки из sysfs
+        if (sm_running && enabled) {
+            ret = job_set_message(HEARTBEAT_ID, message, len);
+            update_account(start);
+            if (ret == -ENOENT) {
+                ret = 0; // Задание 0 удалено через job_del
+            }
+            if (ret) {
+                param_set_charp(old, kp); // Параметр остается согласованным с заданием
+            }
+        }
+    }
+    kfree(old);
+    return ret;
+}
+
+static int enabled_set(const char *val, const struct kernel_param *kp) {
+    bool old = enabled;
+    ktime_t start;
+    int ret;
+
+    ret = param_set_bool(val, kp);
+    if (ret || !sm_running || old == enabled) {
+        return ret;
+    }
+    start = ktime_get();
+    if (enabled) {
+        ret = job_add(HEARTBEAT_ID, emit_period(), message, strnlen(message, MAX_MESSAGE_LEN));
+    } else {
+        ret = job_del(HEARTBEAT_ID);
+    }
+    update_account(start);
+    if (ret == -EEXIST || ret == -ENOENT) {
+        ret = 0; // Задание 0 добавлено или удалено через job_add/job_del
+    }
+    if (ret) {
+        enabled = old;
+    }
+    return ret;
+}
+
+static const struct kernel_param_ops frequency_ops = {
+    .set = frequency_set,
+    .get = param_get_int,
+};
+
+static const struct kernel_param_ops period_ns_ops = {
+    .set = period_ns_set,
+    .get = param_get_ulong,
+};
+
+static const struct kernel_param_ops message_ops = {
+    .set = message_set,
+    .get = param_get_charp,
+    .free = param_free_charp,
+};
+
+static const struct kernel_param_ops enabled_ops = {
+    .flags = KERNEL_PARAM_OPS_FL_NOARG,
+    .set = enabled_set,
+    .get = param_get_bool,
+};
+
+// Сводная статистика всех рабочих потоков
+static void read_stats(struct emit_stats *out) {
+    unsigned int i;
+
+    memset(out, 0, sizeof(*out));
+    for (i = 0; i < nr_workers; i++) {
+        struct sm_worker *w = &worker_pool[i];
+
+        spin_lock(&w->stats_lock);
+        out->wakeups += w->stats.wakeups;
+        out->iterations += w->stats.iterations;
+        out->missed += w->stats.missed;
+        out->last_lateness = max(out->last_lateness, w->stats.last_lateness);
+        out->sum_lateness += w->stats.sum_lateness;
+        out->max_lateness = max(out->max_lateness, w->stats.max_lateness);
+        spin_unlock(&w->stats_lock);
+    }
+}
+
+// Атрибуты sysfs со статистикой
+static ssize_t period_ns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    return sysfs_emit(buf, "%llu\n", emit_period());
+}
+
+static ssize_t wakeups_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct emit_stats s;
+
+    read_stats(&s);
+    return sysfs_emit(buf, "%llu\n", s.wakeups);
+}
+
+static ssize_t iterations_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct emit_stats s;
+
+    read_stats(&s);
+    return sysfs_emit(buf, "%llu\n", s.iterations);
+}
+
+static ssize_t missed_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct emit_stats s;
+
+    read_stats(&s);
+    return sysfs_emit(buf, "%llu\n", s.missed);
+}
+
+static ssize_t last_jitter_ns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct emit_stats s;
+
+    read_stats(&s);
+    return sysfs_emit(buf, "%llu\n", s.last_lateness);
+}
+
+static ssize_t mean_jitter_ns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct emit_stats s;
+
+    read_stats(&s);
+    return sysfs_emit(buf, "%llu\n", s.iterations ? div64_u64(s.sum_lateness, s.iterations) : 0);
+}
+
+static ssize_t max_jitter_ns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct emit_stats s;
+
+    read_stats(&s);
+    return sysfs_emit(buf, "%llu\n", s.max_lateness);
+}
+
+// Сброс статистики записью любого значения
+static ssize_t reset_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    unsigned int i;
+
+    for (i = 0; i < nr_workers; i++) {
+        spin_lock(&worker_pool[i].stats_lock);
+        memset(&worker_pool[i].stats, 0, sizeof(worker_pool[i].stats));
+        spin_unlock(&worker_pool[i].stats_lock);
+    }
+    return count;
+}
+
+// Стоимость изменения параметров: количество, последняя и наибольшая длительность, нс
+static ssize_t update_ns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct update_stats u;
+
+    spin_lock(&update_lock);
+    u = update;
+    spin_unlock(&update_lock);
+    return sysfs_emit(buf, "%llu %llu %llu\n", u.count, u.last_ns, u.max_ns);
+}
+
+// Количество записей, отброшенных при заполнении колец
+static ssize_t dropped_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    unsigned int i;
+    u64 total = 0;
+
+    for (i = 0; i < nr_workers; i++) {
+        if (worker_pool[i].ring) {
+            total += READ_ONCE(worker_pool[i].ring_dropped);
+        }
+    }
+    return sysfs_emit(buf, "%llu\n", total);
+}
+
+// Количество заданий и рабочих потоков
+static ssize_t jobs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    unsigned int i, total = 0;
+
+    for (i = 0; i < nr_workers; i++) {
+        total += READ_ONCE(worker_pool[i].nr);
+    }
+    return sysfs_emit(buf, "%u %u\n", total, nr_workers);
+}
+
+// Добавление задания: "<номер> <период_нс> <сообщение>"
+static ssize_t job_add_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    unsigned long long period;
+    unsigned int id;
+    int pos = 0, ret;
+    size_t len;
+
+    if (sscanf(buf, "%u %llu %n", &id, &period, &pos) < 2 || !pos) {
+        return -EINVAL;
+    }
+    len = strcspn(buf + pos, "\n"); // Сообщение - остаток строки
+    ret = job_add(id, period, buf + pos, len);
+    return ret ? ret : count;
+}
+
+// Удаление задания: "<номер>"
+static ssize_t job_del_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    unsigned int id;
+    int ret;
+
+    ret = kstrtouint(buf, 0, &id);
+    if (ret) {
+        return ret;
+    }
+    ret = job_del(id);
+    return ret ? ret : count;
+}
+
+static struct kobj_attribute period_ns_attr = __ATTR_RO(period_ns);
+static struct kobj_attribute wakeups_attr = __ATTR_RO(wakeups);
+static struct kobj_attribute iterations_attr = __ATTR_RO(iterations);
+static struct kobj_attribute missed_attr = __ATTR_RO(missed);
+static struct kobj_attribute last_jitter_ns_attr = __ATTR_RO(last_jitter_ns);
+static struct kobj_attribute mean_jitter_ns_attr = __ATTR_RO(mean_jitter_ns);
+static struct kobj_attribute max_jitter_ns_attr = __ATTR_RO(max_jitter_ns);
+static struct kobj_attribute reset_attr = __ATTR_WO(reset);
+static struct kobj_attribute dropped_attr = __ATTR_RO(dropped);
+static struct kobj_attribute update_ns_attr = __ATTR_RO(update_ns);
+static struct kobj_attribute jobs_attr = __ATTR_RO(jobs);
+static struct kobj_attribute job_add_attr = __ATTR_WO(job_add);
+static struct kobj_attribute job_del_attr = __ATTR_WO(job_del);
+
+static struct attribute *sleep_attrs[] = {
+    &period_ns_attr.attr,
+    &wakeups_attr.attr,
+    &iterations_attr.attr,
+    &missed_attr.attr,
+    &last_jitter_ns_attr.attr,
+    &mean_jitter_ns_attr.attr,
+    &max_jitter_ns_attr.attr,
+    &reset_attr.attr,
+    &dropped_attr.attr,
+    &update_ns_attr.attr,
+    &jobs_attr.attr,
+    &job_add_attr.attr,
+    &job_del_attr.attr,
+    NULL,
+};
+
+static const struct attribute_group sleep_attr_group = {
+    .attrs = sleep_attrs,
+};
+
+// Есть ли непрочитанные записи
+static bool out_available(void) {
+    unsigned int i;
+
+    for (i = 0; i < nr_workers; i++) {
+        struct sm_worker *w = &worker_pool[i];
+
+        if (smp_load_acquire(&w->ring_head) != READ_ONCE(w->ring->tail)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Перенос целых записей из кольца в буфер пользователя; возвращает количество скопированных байт.
+// tail пишет пользователь, поэтому он ограничивается последними ring_entries записями,
+// а длина записи - размером текста
+static ssize_t ring_drain(struct sm_worker *w, char __user *buf, size_t count) {
+    struct sm_ring_ctrl *ring = w->ring;
+    u32 head = smp_load_acquire(&w->ring_head); // Записи до head опубликованы
+    u32 tail = READ_ONCE(ring->tail);
+    size_t copied = 0, len;
+
+    if (head - tail > ring_entries) {
+        tail = head - ring_entries;
+    }
+    while (tail != head) {
+        struct sm_record *rec = (struct sm_record *)((char *)ring + PAGE_SIZE) + (tail & (ring_entries - 1));
+
+        len = min_t(size_t, READ_ONCE(rec->len), SM_RECORD_TEXT);
+        if (copied + len > count) {
+            break;
+        }
+        if (copy_to_user(buf + copied, rec->text, len)) {
+            return -EFAULT;
+        }
+        copied += len;
+        tail++;
+    }
+    smp_store_release(&ring->tail, tail); // Освобождение записей для потока
+    return copied;
+}
+
+// Чтение строк из колец всех рабочих потоков
+static ssize_t device_read(struct file *file, char __user *buf, size_t count, loff_t *ppos) {
+    ssize_t copied = 0, ret;
+    unsigned int i;
+
+    if (!output_ring) {
+        return -ENODEV; // Вывод идет через printk
+    }
+    if (count < SM_RECORD_TEXT) {
+        return -EINVAL; // Буфер должен вмещать любую запись
+    }
+    for (;;) {
+        if (file->f_flags & O_NONBLOCK) {
+            if (!out_available()) {
+                return -EAGAIN;
+            }
+        } else if (wait_event_interruptible(out_wait, out_available())) {
+            return -ERESTARTSYS;
+        }
+
+        mutex_lock(&out_read_lock);
+        for (i = 0; i < nr_workers && copied < count; i++) {
+            ret = ring_drain(&worker_pool[i], buf + copied, count - copied);
+            if (ret < 0) {
+                mutex_unlock(&out_read_lock);
+                return copied ? copied : ret;
+            }
+            copied += ret;
+        }
+        mutex_unlock(&out_read_lock);
+        if (copied) {
+            return copied;
+        }
+        // Записи забрал другой читатель - ожидание следующих
+    }
+}
+
+static __poll_t device_poll(struct file *file, poll_table *wait) {
+    if (!output_ring) {
+        return EPOLLERR;
+    }
+    poll_wait(file, &out_wait, wait);
+    return out_available() ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+// Отображение кольца рабочего потока i (SM_IOC_RING_INFO): управляющая страница со смещения
+// i * map_size доступна на запись (читатель публикует tail), записи со смещения
+// i * map_size + data_offset - только на чтение
+static int device_mmap(struct file *file, struct vm_area_struct *vma) {
+    unsigned long ring_pages = ring_map_size >> PAGE_SHIFT;
+    unsigned long idx, first, size = vma->vm_end - vma->vm_start;
+
+    if (!output_ring) {
+        return -ENODEV;
+    }
+    idx = vma->vm_pgoff / ring_pages;
+    first = vma->vm_pgoff % ring_pages; // Первая отображаемая страница области кольца
+    if (idx >= nr_workers || first > 1 || size > ring_map_size - (first << PAGE_SHIFT)) {
+        return -EINVAL;
+    }
+    if (first || size > PAGE_SIZE) {
+        // Отображение захватывает записи: запись запрещена, и mprotect() ее не разрешит
+        if (vma->vm_flags & VM_WRITE) {
+            return -EPERM;
+        }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+        vm_flags_clear(vma, VM_MAYWRITE);
+#else
+        vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    }
+    return remap_vmalloc_range(vma, worker_pool[idx].ring, first);
+}
+
+static long device_ioctl(struct file *file, unsigned int cmd, unsigned long arg) {
+    struct sm_ring_info info = {
+        .rings = nr_workers,
+        .entries = ring_entries,
+        .record_size = sizeof(struct sm_record),
+        .data_offset = PAGE_SIZE,
+        .map_size = ring_map_size,
+    };
+
+    switch (cmd) {
+        case SM_IOC_RING_INFO:
+            if (!output_ring) {
+                return -ENODEV;
+            }
+            if (copy_to_user((void __user *)arg, &info, sizeof(info))) {
+                return -EFAULT;
+            }
+            return 0;
+        default:
+            return -ENOTTY;
+    }
+}
+
+// Определение операций с файлом
+static struct file_operations fops = {
+    .owner = THIS_MODULE,
+    .read = device_read,            // Строки из колец всех потоков
+    .poll = device_poll,            // Готовность для poll/epoll
+    .mmap = device_mmap,            // Кольца рабочих потоков
+    .unlocked_ioctl = device_ioctl, // Параметры колец
+};
+
+// Поток, привязанный к процессору cpu
+static struct sm_worker *worker_of_cpu(unsigned int cpu) {
+    unsigned int i;
+
+    for (i = 0; i < nr_workers; i++) {
+        if (worker_pool[i].cpu == cpu) {
+            return &worker_pool[i];
+        }
+    }
+    return NULL;
+}
+
+// Перенос заданий остановленного потока from в поток to; вызывается под jobs_lock.
+// Задания снимаются с конца кучи, поэтому оставшиеся при нехватке памяти сохраняют порядок
+static void worker_move_jobs(struct sm_worker *from, struct sm_worker *to) {
+    mutex_lock(&from->lock);
+    mutex_lock_nested(&to->lock, SINGLE_DEPTH_NESTING);
+    while (from->nr) {
+        struct sm_job *job = from->heap[from->nr - 1];
+
+        if (heap_push(to, job)) {
+            break; // Остаток выполнится после включения процессора
+        }
+        from->nr--;
+        job->worker = to;
+    }
+    mutex_unlock(&to->lock);
+    mutex_unlock(&from->lock);
+    worker_kick(to);
+}
+
+// Выключение процессора: поток паркуется, его задания переходят к другому потоку
+static int sm_cpu_offline(unsigned int cpu) {
+    struct sm_worker *w = worker_of_cpu(cpu), *to;
+
+    if (!w) {
+        return 0;
+    }
+    kthread_park(w->task);
+    mutex_lock(&jobs_lock);
+    w->online = false;
+    to = worker_next();
+    if (to) {
+        worker_move_jobs(w, to);
+    }
+    mutex_unlock(&jobs_lock);
+    return 0;
+}
+
+// Включение процессора: поток снова привязывается к нему и принимает новые задания
+static int sm_cpu_online(unsigned int cpu) {
+    struct sm_worker *w = worker_of_cpu(cpu);
+
+    if (w && !w->online) {
+        kthread_unpark(w->task);
+        mutex_lock(&jobs_lock);
+        w->online = true;
+        mutex_unlock(&jobs_lock);
+        if (w->nr) {
+            worker_kick(w); // Задания, не перенесенные при выключении
+        }
+    }
+    return 0;
+}
+
+// Остановка рабочих потоков и удаление всех заданий
+static void stop_workers(void) {
+    struct sm_job *job;
+    unsigned int i;
+    int id;
+
+    if (hp_state > 0) {
+        cpuhp_remove_state_nocalls(hp_state);
+        hp_state = 0;
+    }
+    if (!worker_pool) {
+        return; // Пул не выделен
+    }
+    for (i = 0; i < nr_workers; i++) {
+        if (!IS_ERR_OR_NULL(worker_pool[i].task)) {
+            kthread_stop(worker_pool[i].task); // Остановка потока
+        }
+        kfree(worker_pool[i].heap);
+        vfree(worker_pool[i].ring);
+    }
+    idr_for_each_entry(&jobs, job, id) {
+        job_free(job);
+    }
+    idr_destroy(&jobs);
+    kfree(worker_pool);
+    worker_pool = NULL;
+    nr_workers = 0;
+}
+
+// Запуск рабочих потоков: по одному на включенный процессор или workers несвязанных потоков
+static int start_workers(void) {
+    unsigned int i, cpu, count = workers ? workers : num_online_cpus();
+
+    worker_pool = kcalloc(count, sizeof(*worker_pool), GFP_KERNEL);
+    if (!worker_pool) {
+        return -ENOMEM;
+    }
+    nr_workers = count;
+    // Все элементы инициализируются до первой ошибки, которую освобождает stop_workers()
+    for (i = 0; i < nr_workers; i++) {
+        mutex_init(&worker_pool[i].lock);
+        spin_lock_init(&worker_pool[i].stats_lock);
+        worker_pool[i].cpu = UINT_MAX;
+        worker_pool[i].online = true;
+    }
+    for (i = 0; i < nr_workers && output_ring; i++) {
+        worker_pool[i].ring = vmalloc_user(ring_map_size); // Обнуленная память, пригодная для mmap()
+        if (!worker_pool[i].ring) {
+            return -ENOMEM;
+        }
+        worker_pool[i].ring->entries = ring_entries;
+        worker_pool[i].ring->record_size = sizeof(struct sm_record);
+    }
+
+    i = 0;
+    for_each_online_cpu(cpu) {
+        struct sm_worker *w = &worker_pool[i];
+
+        if (workers) {
+            w->task = kthread_create(thread_fn, w, "sleep_worker/%u", i);
+        } else {
+            w->task = kthread_create_on_cpu(thread_fn, w, cpu, "sleep_worker/%u");
+            w->cpu = cpu;
+        }
+        if (IS_ERR(w->task)) {
+            printk(KERN_ALERT "Не удалось создать поток\n");
+            return PTR_ERR(w->task);
+        }
+        wake_up_process(w->task);
+        if (++i == nr_workers) {
+            break;
+        }
+    }
+    // Несвязанных потоков может быть больше, чем процессоров
+    for (; i < nr_workers; i++) {
+        struct sm_worker *w = &worker_pool[i];
+
+        w->task = kthread_run(thread_fn, w, "sleep_worker/%u", i);
+        if (IS_ERR(w->task)) {
+            printk(KERN_ALERT "Не удалось создать поток\n");
+            return PTR_ERR(w->task);
+        }
+    }
+
+    // Потоки, привязанные к процессорам, паркуются при их выключении
+    if (!workers) {
+        int ret = cpuhp_setup_state_nocalls_cpuslocked(CPUHP_AP_ONLINE_DYN, "sleep_module:online",
+                                                       sm_cpu_online, sm_cpu_offline);
+
+        if (ret < 0) {
+            return ret;
+        }
+        hp_state = ret;
     }
     return 0;
 }
 
+// Запрет изменения задания 0 через параметры и остановка рабочих потоков
+static void stop_running(void) {
+    kernel_param_lock(THIS_MODULE);
+    sm_running = false;
+    kernel_param_unlock(THIS_MODULE);
+    stop_workers();
+}
+
 static int __init sleep_module_init(void) {
+    int ret;
+
     // Инициализация модуля
-    task = kthread_run(thread_fn, NULL, "my_thread"); // Запуск потока
-    if (IS_ERR(task)) {
-        printk(KERN_ALERT "Не удалось создать поток\n");
-        return PTR_ERR(task);
+    if (!emit_period_valid()) {
+        printk(KERN_ALERT "Период должен быть не меньше %u нс\n", MIN_PERIOD_NS);
+        return -EINVAL;
+    }
+    if (sysfs_streq(output, "ring")) {
+        if (!is_power_of_2(ring_entries)) {
+            printk(KERN_ALERT "ring_entries должно быть степенью двойки\n");
+            return -EINVAL;
+        }
+        output_ring = true;
+        ring_map_size = PAGE_SIZE + PAGE_ALIGN((size_t)ring_entries * sizeof(struct sm_record));
+    } else if (!sysfs_streq(output, "printk")) {
+        printk(KERN_ALERT "Неизвестный способ вывода: %s\n", output);
+        return -EINVAL;
+    }
+
+    cpus_read_lock();
+    ret = start_workers();
+    cpus_read_unlock();
+    if (ret) {
+        stop_workers();
+        return ret;
+    }
+
+    // Задание, заданное параметрами модуля; с этого момента их изменения применяются к нему
+    kernel_param_lock(THIS_MODULE);
+    ret = enabled ? job_add(HEARTBEAT_ID, emit_period(), message, strnlen(message, MAX_MESSAGE_LEN)) : 0;
+    sm_running = !ret;
+    kernel_param_unlock(THIS_MODULE);
+    if (ret) {
+        stop_workers();
+        return ret;
+    }
+
+    // Каталог sysfs со статистикой и управлением заданиями
+    sleep_kobj = kobject_create_and_add("sleep_module", kernel_kobj);
+    if (!sleep_kobj) {
+        stop_running();
+        return -ENOMEM;
+    }
+    ret = sysfs_create_group(sleep_kobj, &sleep_attr_group);
+    if (ret) {
+        kobject_put(sleep_kobj);
+        stop_running();
+        return ret;
+    }
+
+    // Символьное устройство для чтения колец
+    major = register_chrdev(0, DEVICE_NAME, &fops);
+    if (major < 0) {
+        printk(KERN_ALERT "Не удалось зарегистрировать устройство\n");
+        kobject_put(sleep_kobj);
+        stop_running();
+        return major;
     }
     return 0;
 }
 
 static void __exit sleep_module_exit(void) {
     // Выгрузка модуля
-    if (task) {
-        kthread_stop(task); // Остановка потока
-    }
+    unregister_chrdev(major, DEVICE_NAME); // Удаление символьного устройства
+    kobject_put(sleep_kobj); // Удаление каталога sysfs
+    stop_running();
     printk(KERN_INFO "Модуль выгружен\n");
 }
 
@@ -0,0 +1,48 @@
+#ifndef SLEEP_MODULE_H
+#define SLEEP_MODULE_H
+
+// Общий для модуля и пользовательских программ интерфейс устройства sleep_module
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define SM_RING_ALIGN 128  // Индексы записи и чтения находятся в разных кэш-линиях
+#define SM_RECORD_TEXT 240 // Размер текста записи вместе с завершающим '\n'
+
+// Запись кольца: отформатированная строка "[номер] сообщение\n" без завершающего нуля
+struct sm_record {
+    __u64 time_ns;             // Время вывода (CLOCK_MONOTONIC)
+    __u32 id;                  // Номер задания
+    __u16 len;                 // Длина текста
+    __u16 reserved;
+    char text[SM_RECORD_TEXT]; // Текст
+};
+
+// Управляющая страница кольца рабочего потока (начало его области mmap()); записи - с data_offset.
+// Индексы свободно растут, позиция записи - индекс & (entries - 1). Страница отображается на
+// запись отдельно (длина data_offset), записи и область целиком - только на чтение.
+// Модуль не читает head и dropped со страницы, а tail ограничивает последними entries записями
+struct sm_ring_ctrl {
+    __u32 head;                            // Индекс записи (пишет модуль, release)
+    __u8 pad0[SM_RING_ALIGN - sizeof(__u32)];
+    __u32 tail;                            // Индекс чтения (пишет читатель, release)
+    __u8 pad1[SM_RING_ALIGN - sizeof(__u32)];
+    __u64 dropped;                         // Количество отброшенных при заполнении записей
+    __u32 entries;                         // Емкость кольца (степень двойки)
+    __u32 record_size;                     // Размер struct sm_record
+};
+
+// Параметры колец для mmap()
+struct sm_ring_info {
+    __u32 rings;       // Количество колец (рабочих потоков)
+    __u32 entries;     // Емкость кольца (степень двойки)
+    __u32 record_size; // Размер struct sm_record
+    __u32 reserved;
+    __u64 data_offset; // Смещение записей от начала области кольца
+    __u64 map_size;    // Размер области кольца; смещение mmap() для кольца i - i * map_size,
+                       // для его записей - i * map_size + data_offset
+};
+
+#define SM_IOC_RING_INFO _IOR('s', 1, struct sm_ring_info) // Параметры колец
+
+#endif // SLEEP_MODULE_H
@@ -2,9 +2,21 @@
 #include <linux/kernel.h>   
 #include <linux/init.h>     
 #include <linux/timer.h>    
+#include <linux/mutex.h>
 #include <linux/fs.h>        
 #include <linux/uaccess.h>   
 #include <linux/slab.h>     
+#include <linux/atomic.h>
+#include <linux/kobject.h>
+#include <linux/sysfs.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+
+#include "symbolic_driver.h"
 
 #define DEVICE_NAME "symbolic_driver" // Имя устройства
 #define CLASS_NAME "symbolic"          // Имя класса устройства
@@ -12,62 +24,329 @@
 MODULE_LICENSE("GPL");                // Лицензия модуля
 MODULE_DESCRIPTION("Символьный драйвер с таймером и интерфейсом sysfs"); // Описание модуля
 
-static int global_variable = 0;       // Глобальная переменная для хранения значения
-static struct timer_list my_timer;    // Таймер для периодического обновления переменной
-static bool timer_running = false;     // Флаг, указывающий, запущен ли таймер
+static atomic64_t global_variable = ATOMIC64_INIT(0); // Глобальная переменная для хранения значения
+#define MIN_PERIOD_NS 10000 // Наименьший период таймера (10 мкс)
+
+// Состояние таймера; переходы выполняются только под timer_lock
+enum timer_state {
+    TIMER_STOPPED,  // Таймер остановлен
+    TIMER_RUNNING,  // Таймер запущен
+    TIMER_SHUTDOWN, // Модуль выгружается, запуск запрещен
+};
+
+static struct hrtimer my_timer;       // Таймер для периодического обновления переменной
+static enum timer_state timer_state = TIMER_STOPPED; // Состояние таймера
+static DEFINE_MUTEX(timer_lock);      // Сериализация запуска и остановки таймера
+static u64 period_ns = NSEC_PER_SEC;  // Период таймера в наносекундах
+
+static unsigned int counters; // Количество виртуальных счетчиков (0 - режим выключен)
+module_param(counters, uint, S_IRUGO);
+MODULE_PARM_DESC(counters, "Количество виртуальных счетчиков с собственными периодами");
+
+static unsigned long tick_ns = NSEC_PER_MSEC; // Период общего такта виртуальных счетчиков
+module_param(tick_ns, ulong, S_IRUGO);
+MODULE_PARM_DESC(tick_ns, "Период общего такта виртуальных счетчиков в наносекундах");
+
+// Виртуальные счетчики хранятся структурой массивов: такт последовательно просматривает
+// только сроки, а снимок значений отображается в пользовательское пространство целиком
+static struct hrtimer counters_timer;       // Общий такт всех счетчиков
+static DEFINE_SPINLOCK(counters_lock);      // Защита массивов от такта и управления
+static struct symbolic_counters_hdr *counters_map; // Заголовок и значения (vmalloc_user)
+static size_t counters_map_size;            // Размер снимка
+static u64 *counter_values;                 // Значения счетчиков (часть counters_map)
+static u64 *counter_periods;                // Периоды, нс
+static u64 *counter_next;                   // Абсолютные сроки следующего увеличения, нс
+static u64 counters_min_next;               // Ближайший срок среди всех счетчиков
+
+// Указатель на объект kobject для создания интерфейса sysfs
+static struct kobject *example_kobj;
+static struct kernfs_node *value_kn; // Узел файла value для уведомлений из softirq
+
+// Уведомление ожидающих в poll() на файле value; sysfs_notify() ищет узел под мьютексом
+// и не вызывается из таймера, поэтому узел найден заранее
+static void notify_value(void) {
+    sysfs_notify_dirent(value_kn);
+}
 
 // Функция обратного вызова для таймера
-static void timer_callback(struct timer_list *t) {
-    global_variable++; // Увеличиваем глобальную переменную
-    mod_timer(&my_timer, jiffies + msecs_to_jiffies(1000)); // Перезапускаем таймер на 1 секунду
+static enum hrtimer_restart timer_callback(struct hrtimer *t) {
+    atomic64_inc(&global_variable); // Увеличиваем глобальную переменную
+    notify_value();
+    // Следующий срок от предыдущего; новый период действует со следующего срабатывания
+    hrtimer_forward_now(t, ns_to_ktime(READ_ONCE(period_ns)));
+    return HRTIMER_RESTART; // Остановка - только через hrtimer_cancel() под timer_lock
 }
 
-// Функция чтения значения глобальной переменной
-static ssize_t read_variable(struct file *file, char __user *buffer, size_t len, loff_t *offset) {
-    char buf[32]; // Буфер для хранения строки с значением
+// Начало и конец изменения значений для читателей снимка; вызываются под counters_lock
+static void counters_write_begin(void) {
+    WRITE_ONCE(counters_map->seq, counters_map->seq + 1);
+    smp_wmb();
+}
+
+static void counters_write_end(void) {
+    smp_wmb();
+    WRITE_ONCE(counters_map->seq, counters_map->seq + 1);
+}
+
+// Такт виртуальных счетчиков: за одно срабатывание увеличиваются все счетчики с наступившим сроком
+static enum hrtimer_restart counters_tick(struct hrtimer *t) {
+    u64 now = ktime_get_ns(), min_next = U64_MAX, n;
+    unsigned int i;
+
+    spin_lock(&counters_lock);
+    if (now >= counters_min_next) {
+        counters_write_begin();
+        for (i = 0; i < counters; i++) {
+            if (counter_next[i] <= now) {
+                // Пропущенные такты засчитываются, срок остается кратным периоду
+                n = div64_u64(now - counter_next[i], counter_periods[i]) + 1;
+                counter_values[i] += n;
+                counter_next[i] += n * counter_periods[i];
+            }
+            min_next = min(min_next, counter_next[i]);
+        }
+        counters_write_end();
+        counters_min_next = min_next;
+    }
+    WRITE_ONCE(counters_map->ticks, counters_map->ticks + 1);
+    spin_unlock(&counters_lock);
+
+    hrtimer_forward_now(t, ns_to_ktime(tick_ns));
+    return HRTIMER_RESTART;
+}
+
+// Сброс всех виртуальных счетчиков
+static void counters_reset(void) {
+    if (!counters) {
+        return;
+    }
+    spin_lock_bh(&counters_lock);
+    counters_write_begin();
+    memset(counter_values, 0, counters * sizeof(*counter_values));
+    counters_write_end();
+    spin_unlock_bh(&counters_lock);
+}
+
+// Установка периода счетчиков first..last; новый отсчет начинается с текущего момента
+static int counters_set_period(unsigned int first, unsigned int last, u64 period) {
+    u64 now = ktime_get_ns();
+    unsigned int i;
+
+    if (first > last || last >= counters || period < tick_ns) {
+        return -EINVAL;
+    }
+    spin_lock_bh(&counters_lock);
+    for (i = first; i <= last; i++) {
+        counter_periods[i] = period;
+        counter_next[i] = now + period;
+    }
+    counters_min_next = min(counters_min_next, now + period);
+    spin_unlock_bh(&counters_lock);
+    return 0;
+}
+
+// Снимок счетчиков: заголовок и значения. Чтение копирует под блокировкой, но sysfs передает
+// не больше страницы за вызов read(): снимок из нескольких вызовов согласован, только если seq
+// в начале файла не изменился после чтения последней части. Согласованный снимок без
+// повторов - через mmap() с проверкой seq
+static ssize_t counters_read(struct file *file, struct kobject *kobj, struct bin_attribute *attr,
+                             char *buf, loff_t off, size_t count) {
+    if (off >= counters_map_size) {
+        return 0;
+    }
+    count = min_t(size_t, count, counters_map_size - off);
+    spin_lock_bh(&counters_lock);
+    memcpy(buf, (char *)counters_map + off, count);
+    spin_unlock_bh(&counters_lock);
+    return count;
+}
+
+static int counters_mmap(struct file *file, struct kobject *kobj, struct bin_attribute *attr,
+                         struct vm_area_struct *vma) {
+    if (vma->vm_flags & VM_WRITE) {
+        return -EPERM; // Снимок только для чтения
+    }
+    return remap_vmalloc_range(vma, counters_map, vma->vm_pgoff);
+}
+
+static struct bin_attribute counters_attr = {
+    .attr = { .name = "counters", .mode = S_IRUGO },
+    .read = counters_read,
+    .mmap = counters_mmap,
+};
+
+// Период счетчиков: "<номер> <период_нс>" или "<первый>-<последний> <период_нс>"
+static ssize_t counter_period_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t len) {
+    unsigned int first, last;
+    unsigned long long period;
     int ret;
 
-    // Форматируем строку с текущим значением глобальной переменной
-    ret = snprintf(buf, sizeof(buf), "%d\n", global_variable);
-    return simple_read_from_buffer(buffer, len, offset, buf, ret); // Читаем из буфера в пользовательское пространство
+    if (sscanf(buf, "%u-%u %llu", &first, &last, &period) != 3) {
+        if (sscanf(buf, "%u %llu", &first, &period) != 2) {
+            return -EINVAL;
+        }
+        last = first;
+    }
+    ret = counters_set_period(first, last, period);
+    return ret ? ret : len;
 }
 
-// Функция для запуска таймера
-static ssize_t start_timer(struct file *file, const char __user *buffer, size_t len, loff_t *offset) {
-    if (!timer_running) { // Проверяем, запущен ли таймер
-        timer_running = true; // Устанавливаем флаг, что таймер запущен
-        mod_timer(&my_timer, jiffies + msecs_to_jiffies(1000)); // Запускаем таймер
+static struct kobj_attribute counter_period_attr = __ATTR_WO(counter_period);
+
+// Освобождение виртуальных счетчиков
+static void counters_free(void) {
+    vfree(counters_map);
+    kvfree(counter_periods);
+    kvfree(counter_next);
+}
+
+// Выделение массивов и запуск общего такта; все счетчики начинают с периода period_ns
+static int counters_init(void) {
+    u64 now = ktime_get_ns(), period;
+    unsigned int i;
+
+    if (tick_ns < MIN_PERIOD_NS) {
+        pr_alert("tick_ns must be at least %u\n", MIN_PERIOD_NS);
+        return -EINVAL;
+    }
+    counters_map_size = PAGE_SIZE + PAGE_ALIGN((size_t)counters * sizeof(u64));
+    counters_map = vmalloc_user(counters_map_size); // Обнуленная память, пригодная для mmap()
+    counter_periods = kvmalloc_array(counters, sizeof(u64), GFP_KERNEL);
+    counter_next = kvmalloc_array(counters, sizeof(u64), GFP_KERNEL);
+    if (!counters_map || !counter_periods || !counter_next) {
+        counters_free();
+        return -ENOMEM;
+    }
+    counters_map->nr = counters;
+    counters_map->tick_ns = tick_ns;
+    counters_map->data_offset = PAGE_SIZE;
+    counter_values = (u64 *)((char *)counters_map + PAGE_SIZE);
+
+    period = max_t(u64, period_ns, tick_ns);
+    for (i = 0; i < counters; i++) {
+        counter_periods[i] = period;
+        counter_next[i] = now + period;
     }
-    return len; // Возвращаем количество байт, записанных в буфер
+    counters_min_next = now + period;
+    counters_attr.size = counters_map_size;
+
+    // Такт в контексте softirq: управление блокирует его через spin_lock_bh()
+    hrtimer_init(&counters_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
+    counters_timer.function = counters_tick;
+    hrtimer_start(&counters_timer, ns_to_ktime(tick_ns), HRTIMER_MODE_REL_SOFT);
+    return 0;
 }
 
-// Функция для остановки таймера
-static ssize_t stop_timer(struct file *file, const char __user *buffer, size_t len, loff_t *offset) {
-    if (timer_running) { // Проверяем, запущен ли таймер
-        del_timer(&my_timer); // Останавливаем таймер
-        timer_running = false; // Сбрасываем флаг
+// Функция чтения значения глобальной переменной
+static ssize_t value_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    return sysfs_emit(buf, "%lld\n", atomic64_read(&global_variable));
+}
+
+// Запуск таймера; повторный запуск не меняет срок
+static int timer_start(void) {
+    int ret = 0;
+
+    mutex_lock(&timer_lock);
+    if (timer_state == TIMER_STOPPED) {
+        timer_state = TIMER_RUNNING;
+        hrtimer_start(&my_timer, ns_to_ktime(READ_ONCE(period_ns)), HRTIMER_MODE_REL_SOFT);
+    } else if (timer_state == TIMER_SHUTDOWN) {
+        ret = -ENODEV;
+    }
+    mutex_unlock(&timer_lock);
+    return ret;
+}
+
+// Остановка таймера; после возврата обработчик не выполняется и не перезапустит таймер.
+// shutdown запрещает последующие запуски (выгрузка модуля); из TIMER_SHUTDOWN выхода нет,
+// поэтому stop, записанный во время выгрузки, не разрешит повторный запуск
+static void timer_stop(bool shutdown) {
+    mutex_lock(&timer_lock);
+    if (timer_state == TIMER_RUNNING) {
+        hrtimer_cancel(&my_timer); // Ожидание выполняющегося обработчика
+    }
+    if (timer_state != TIMER_SHUTDOWN) {
+        timer_state = shutdown ? TIMER_SHUTDOWN : TIMER_STOPPED;
     }
-    return len; // Возвращаем количество байт, записанных в буфер
+    mutex_unlock(&timer_lock);
+}
+
+// Функция для запуска таймера
+static ssize_t start_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t len) {
+    int ret = timer_start();
+
+    return ret ? ret : len; // Возвращаем количество обработанных байт
+}
+
+// Функция для остановки таймера
+static ssize_t stop_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t len) {
+    timer_stop(false);
+    return len; // Возвращаем количество обработанных байт
+}
+
+// Функция чтения состояния таймера
+static ssize_t running_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    return sysfs_emit(buf, "%d\n", READ_ONCE(timer_state) == TIMER_RUNNING);
 }
 
 // Функция для сброса глобальной переменной
-static ssize_t reset_variable(struct file *file, const char __user *buffer, size_t len, loff_t *offset) {
-    global_variable = 0; // Сбрасываем значение глобальной переменной
-    return len; // Возвращаем количество байт, записанных в буфер
+static ssize_t reset_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t len) {
+    atomic64_set(&global_variable, 0); // Сбрасываем значение глобальной переменной
+    counters_reset(); // И виртуальные счетчики
+    notify_value();
+    return len; // Возвращаем количество обработанных байт
+}
+
+// Функции чтения и установки периода таймера
+static ssize_t period_ns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    return sysfs_emit(buf, "%llu\n", READ_ONCE(period_ns));
 }
 
-// Структура операций с файлами
-static struct file_operations fops = {
-    .owner = THIS_MODULE, // Указываем, что владелец — текущий модуль
-    .read = read_variable, // Указываем функцию чтения
-    .write = start_timer,  // Указываем функцию записи для запуска таймера
+static ssize_t period_ns_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t len) {
+    u64 val;
+    int ret;
+
+    ret = kstrtou64(buf, 0, &val);
+    if (ret) {
+        return ret;
+    }
+    if (val < MIN_PERIOD_NS) {
+        return -EINVAL; // Слишком малый период
+    }
+    WRITE_ONCE(period_ns, val); // Новый период действует со следующего срабатывания
+    return len;
+}
+
+// Атрибуты sysfs: чтение и сброс переменной, запуск и остановка таймера, период
+static struct kobj_attribute value_attr = __ATTR_RO(value);
+static struct kobj_attribute start_attr = __ATTR_WO(start);
+static struct kobj_attribute stop_attr = __ATTR_WO(stop);
+static struct kobj_attribute reset_attr = __ATTR_WO(reset);
+static struct kobj_attribute period_ns_attr = __ATTR_RW(period_ns);
+static struct kobj_attribute running_attr = __ATTR_RO(running);
+
+static struct attribute *symbolic_attrs[] = {
+    &value_attr.attr,
+    &start_attr.attr,
+    &stop_attr.attr,
+    &reset_attr.attr,
+    &period_ns_attr.attr,
+    &running_attr.attr,
+    NULL,
 };
 
-// Указатель на объект kobject для создания интерфейса sysfs
-static struct kobject *example_kobj;
+static const struct attribute_group symbolic_attr_group = {
+    .attrs = symbolic_attrs,
+};
 
 // Функция инициализации модуля
 static int __init symbolic_driver_init(void) {
+    int ret;
+
+    // Инициализируем таймер до появления файлов управления
+    hrtimer_init(&my_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
+    my_timer.function = timer_callback;
+
     // Создаем kobject для интерфейса sysfs
     example_kobj = kobject_create_and_add(DEVICE_NAME, kernel_kobj);
     if (!example_kobj) {
@@ -75,20 +354,52 @@ static int __init symbolic_driver_init(void) {
     }
 
     // Создаем записи в sysfs для управления таймером и чтения переменной
-    sysfs_create_file(example_kobj, &fops); // Для чтения переменной
-    sysfs_create_file(example_kobj, &fops); // Для запуска таймера
-    sysfs_create_file(example_kobj, &fops); // Для остановки таймера
-    sysfs_create_file(example_kobj, &fops); // Для сброса переменной
+    ret = sysfs_create_group(example_kobj, &symbolic_attr_group);
+    if (ret) {
+        kobject_put(example_kobj);
+        return ret;
+    }
+    value_kn = sysfs_get_dirent(example_kobj->sd, "value");
+    if (!value_kn) {
+        kobject_put(example_kobj);
+        return -ENOENT;
+    }
 
-    // Инициализируем таймер
-    timer_setup(&my_timer, timer_callback, 0);
+    // Режим виртуальных счетчиков
+    if (counters) {
+        ret = counters_init();
+        if (ret) {
+            kobject_put(example_kobj);
+            sysfs_put(value_kn);
+            return ret;
+        }
+        ret = sysfs_create_bin_file(example_kobj, &counters_attr);
+        if (!ret) {
+            ret = sysfs_create_file(example_kobj, &counter_period_attr.attr);
+        }
+        if (ret) {
+            hrtimer_cancel(&counters_timer);
+            kobject_put(example_kobj);
+            sysfs_put(value_kn);
+            counters_free();
+            return ret;
+        }
+    }
     return 0; // Возвращаем 0 для успешной инициализации
 }
 
 // Функция очистки модуля
 static void __exit symbolic_driver_exit(void) {
-    del_timer(&my_timer); // Останавливаем таймер при выгрузке модуля
-    kobject_put(example_kobj); // Освобождаем kobject
+    // Сначала синхронная остановка: после нее обработчики не обращаются к kobject
+    timer_stop(true); // Останавливаем таймер и ждем завершения обработчика
+    if (counters) {
+        hrtimer_cancel(&counters_timer); // Останавливаем такт виртуальных счетчиков
+    }
+    kobject_put(example_kobj); // Удаляем файлы управления и ждем выполняющихся вызовов
+    sysfs_put(value_kn);
+    if (counters) {
+        counters_free();
+    }
 }
 
 // Указываем функции инициализации и очистки модуля
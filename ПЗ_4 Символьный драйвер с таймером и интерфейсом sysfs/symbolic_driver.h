@@ -0,0 +1,21 @@
+#ifndef SYMBOLIC_DRIVER_H
+#define SYMBOLIC_DRIVER_H
+
+// Общий для модуля и пользовательских программ формат снимка виртуальных счетчиков
+// (/sys/kernel/symbolic_driver/counters)
+
+#include <linux/types.h>
+
+// Заголовок снимка (начало файла). Значения счетчиков - массив __u64 со смещения data_offset.
+// seq нечетен, пока такт обновляет значения: согласованный снимок читается между двумя
+// одинаковыми четными seq. read() возвращает не больше страницы за вызов, поэтому при чтении
+// через read() seq перечитывается после последней части и снимок повторяется при изменении
+struct symbolic_counters_hdr {
+    __u32 seq;         // Счетчик обновлений
+    __u32 nr;          // Количество счетчиков
+    __u64 tick_ns;     // Период общего такта
+    __u64 ticks;       // Количество тактов
+    __u64 data_offset; // Смещение значений от начала файла
+};
+
+#endif // SYMBOLIC_DRIVER_H